@@ -0,0 +1,90 @@
+/**
+ * @file aligned.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Cache-line aligned filters that do not false-share between threads
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef ALIGNED_FILTER_HPP
+#define ALIGNED_FILTER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "filtering/filter.hpp"
+
+/**
+ * @brief Size in bytes that keeps two objects off each other's cache lines
+ *
+ * std::hardware_destructive_interference_size changes with the compiler's
+ * tuning flags, which makes it unsafe in a header-only library's types, so
+ * the size is fixed here instead. Define FILTERING_CACHE_LINE_SIZE to override
+ * it, e.g. 128 on targets that prefetch cache lines in pairs.
+ */
+#ifndef FILTERING_CACHE_LINE_SIZE
+#define FILTERING_CACHE_LINE_SIZE 64
+#endif
+
+constexpr std::size_t kCacheLineSize{FILTERING_CACHE_LINE_SIZE};
+
+// CACHE ALIGNED FILTER ********************************************************
+
+/**
+ * @brief A filter that owns whole cache lines
+ *
+ * Filters are a few words of state, so filters owned by different threads
+ * easily share a cache line, either side by side in an array or as adjacent
+ * heap allocations from `clone()`. Every update by one thread then evicts the
+ * line from the other threads' caches (false sharing), even though they never
+ * touch the same filter.
+ *
+ * CacheAligned<F> is an F that is aligned to and padded out to a multiple of
+ * kCacheLineSize, so nothing else can share its lines. Arrays of them are
+ * laid out one filter per line, `new` uses the aligned operator new, and
+ * `clone()` returns another CacheAligned<F>, so MultiStreamFilter and other
+ * cloning containers keep the alignment.
+ *
+ *    std::vector<CacheAligned<ExponentialFilter<double>>> filters(
+ *        threads, CacheAligned<ExponentialFilter<double>>{0.1});
+ *
+ * @tparam F - any filter type
+ */
+template <typename F>
+class alignas(kCacheLineSize) CacheAligned : public F {
+ public:
+  using F::F;
+
+  /**
+   * @brief Construct a new Cache Aligned object from a copy of a filter
+   *
+   * @param filter - filter whose configuration and state are copied
+   */
+  explicit CacheAligned(const F& filter) : F{filter} {}
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter
+   * objects. The clone is cache aligned as well.
+   *
+   */
+  virtual auto clone() const -> decltype(F::clone()) override {
+    return std::make_unique<CacheAligned<F>>(*this);
+  }
+};
+
+/**
+ * @brief Allocate a filter on its own cache lines
+ *
+ * @tparam F - filter type
+ * @param args - arguments forwarded to the constructor of F
+ * @return std::unique_ptr<CacheAligned<F>>
+ */
+template <typename F, typename... Args>
+std::unique_ptr<CacheAligned<F>> make_cache_aligned(Args&&... args) {
+  return std::make_unique<CacheAligned<F>>(std::forward<Args>(args)...);
+}
+
+#endif
@@ -0,0 +1,407 @@
+/**
+ * @file autotune.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Pick the fastest implementation of a filter by measuring it
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef AUTOTUNE_FILTER_HPP
+#define AUTOTUNE_FILTER_HPP
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "filtering/chain.hpp"
+#include "filtering/filter.hpp"
+#include "filtering/fir.hpp"
+
+/**
+ * @brief One implementation of a filter configuration
+ *
+ */
+template <typename T>
+struct Candidate {
+  std::string name{};                                  ///< Stored in profiles
+  std::function<std::unique_ptr<Filter<T>>()> make{};  ///< Builds the filter
+};
+
+/**
+ * @brief Measured cost of a candidate
+ *
+ */
+struct TuneResult {
+  std::string name{};       ///< Candidate name
+  double ns_per_sample{0};  ///< Best time per sample of a channel [ns]
+};
+
+/**
+ * @brief Identify the CPU a profile was measured on, from the model name in
+ * /proc/cpuinfo and the number of hardware threads
+ *
+ */
+inline std::string cpu_signature() {
+  std::string model{"unknown"};
+  std::ifstream cpuinfo{"/proc/cpuinfo"};
+  for (std::string line; std::getline(cpuinfo, line);) {
+    if (line.compare(0, 10, "model name") == 0) {
+      const std::size_t colon{line.find(':')};
+      if (colon != std::string::npos) {
+        model = line.substr(line.find_first_not_of(' ', colon + 1));
+      }
+      break;
+    }
+  }
+  return model + " x" + std::to_string(std::thread::hardware_concurrency());
+}
+
+// PROFILE *********************************************************************
+
+/**
+ * @brief Winning implementations saved per (CPU, filter, channel count)
+ *
+ * The profile is a text file with one tab-separated line per configuration:
+ *    key <TAB> candidate name <TAB> ns per sample
+ */
+class FilterProfile {
+ public:
+  /**
+   * @brief Profile location: $FILTERING_PROFILE, or filtering_profile.txt in
+   * the working directory
+   *
+   */
+  static std::string default_path() {
+    const char* path{std::getenv("FILTERING_PROFILE")};
+    return path != nullptr ? path : "filtering_profile.txt";
+  }
+
+  /**
+   * @brief Load a profile. A missing file is an empty profile.
+   *
+   * @param path - profile file
+   */
+  explicit FilterProfile(std::string path = default_path())
+      : _path{std::move(path)} {
+    read(_path, _entries);
+  }
+
+  /**
+   * @brief The saved winner for a configuration, or nullptr
+   *
+   */
+  const TuneResult* find(const std::string& key) const {
+    const auto entry{_entries.find(key)};
+    return entry == _entries.end() ? nullptr : &entry->second;
+  }
+
+  /**
+   * @brief Record the winner for a configuration and rewrite the file
+   *
+   * Entries saved meanwhile by other processes are read back and kept, and
+   * the file is replaced atomically by renaming a temporary file, so
+   * processes tuning at the same time never leave a partial profile.
+   *
+   * @return true - the file was written; otherwise the winner is only kept in
+   * memory, e.g. on a read-only file system
+   */
+  bool store(const std::string& key, const TuneResult& result) {
+    std::map<std::string, TuneResult> saved;
+    read(_path, saved);
+    for (auto& entry : saved) {
+      _entries.insert(std::move(entry));
+    }
+    _entries[key] = result;
+
+    std::ostringstream suffix;
+    suffix << ".tmp." << ::getpid() << "." << std::this_thread::get_id();
+    const std::string temporary{_path + suffix.str()};
+    {
+      std::ofstream file{temporary};
+      for (const auto& entry : _entries) {
+        file << entry.first << '\t' << entry.second.name << '\t'
+             << entry.second.ns_per_sample << '\n';
+      }
+      if (!file.flush()) {
+        std::remove(temporary.c_str());
+        return false;
+      }
+    }
+    if (std::rename(temporary.c_str(), _path.c_str()) != 0) {
+      std::remove(temporary.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  const std::string& path() const { return _path; }
+
+ private:
+  /**
+   * @brief Add the entries of a profile file to `entries`. A missing file
+   * adds nothing, and malformed lines are skipped.
+   *
+   */
+  static void read(const std::string& path,
+                   std::map<std::string, TuneResult>& entries) {
+    std::ifstream file{path};
+    for (std::string line; std::getline(file, line);) {
+      std::stringstream fields{line};
+      std::string key, name, cost;
+      if (!std::getline(fields, key, '\t') ||
+          !std::getline(fields, name, '\t') || key.empty() || name.empty()) {
+        continue;
+      }
+      std::getline(fields, cost, '\t');
+      char* end{nullptr};
+      const double ns_per_sample{std::strtod(cost.c_str(), &end)};
+      if (cost.empty() || (*end != '\0')) {
+        continue;
+      }
+      entries[key] = {name, ns_per_sample};
+    }
+  }
+
+  std::string _path;                           ///< Profile file
+  std::map<std::string, TuneResult> _entries;  ///< Winner per configuration
+};
+
+// AUTOTUNER *******************************************************************
+
+/**
+ * @brief Build filters with the implementation that measured fastest on this
+ * CPU for the same configuration and channel count
+ *
+ * `make` looks the configuration up in the profile; if it has not been
+ * measured, every candidate is run over `channels` channels of a test signal
+ * (so the cost includes the cache footprint of that many filters), and the
+ * fastest is saved to the profile before it is built. Run `tune` at install
+ * time to fill the profile ahead of deployment.
+ *
+ * Built-in candidates exist for text specifications (see make_filter): a
+ * moving average with zero warm-up runs either as a running sum or as a
+ * direct FIR with equal taps. Other specifications have a single
+ * implementation. Register more, e.g. an FFT convolution for long FIR
+ * filters, with `add_candidates`.
+ *
+ * @tparam T - data type used by the filters
+ */
+template <typename T>
+class Autotuner {
+ public:
+  /**
+   * @brief Construct a new Autotuner object reading a profile
+   *
+   * @param profile_path - profile file
+   */
+  explicit Autotuner(std::string profile_path = FilterProfile::default_path())
+      : _profile{std::move(profile_path)} {}
+
+  // TUNING FUNCTIONS **********************************************************
+
+  /**
+   * @brief Build a filter with the profiled winner, measuring it first if
+   * the profile does not know the configuration. Configurations with a single
+   * implementation are built without measuring.
+   *
+   * @param spec - filter specification, e.g. "ma:8"
+   * @param channels - number of channels the filter will run on
+   */
+  std::unique_ptr<Filter<T>> make(const std::string& spec,
+                                  const int channels = 1) {
+    check_channels(channels);
+    const std::vector<Candidate<T>> options{candidates(spec)};
+    if (options.size() == 1) {
+      return options[0].make();
+    }
+    const TuneResult* saved{_profile.find(key(spec, channels))};
+    const Candidate<T>* winner{saved != nullptr ? find(options, saved->name)
+                                                : nullptr};
+    if (winner == nullptr) {
+      winner = find(options, tune(spec, channels).name);
+    }
+    return winner->make();
+  }
+
+  /**
+   * @brief Measure every candidate of a configuration and save the fastest
+   *
+   * @param spec - filter specification
+   * @param channels - number of channels the filter will run on
+   * @return TuneResult - the winner
+   */
+  TuneResult tune(const std::string& spec, const int channels = 1) {
+    check_channels(channels);
+    _results.clear();
+    for (const auto& option : candidates(spec)) {
+      _results.push_back({option.name, measure(option, channels)});
+    }
+    const TuneResult best{*std::min_element(
+        _results.begin(), _results.end(), [](const auto& a, const auto& b) {
+          return a.ns_per_sample < b.ns_per_sample;
+        })};
+    _profile.store(key(spec, channels), best);
+    return best;
+  }
+
+  /**
+   * @brief Register the implementations of a configuration, replacing the
+   * built-in ones
+   *
+   * @param spec - filter specification the candidates implement
+   * @param options - equivalent implementations
+   */
+  void add_candidates(const std::string& spec,
+                      std::vector<Candidate<T>> options) {
+    if (options.empty()) {
+      throw std::invalid_argument("No candidates for filter '" + spec + "'");
+    }
+    _registered[spec] = std::move(options);
+  }
+
+  /**
+   * @brief Implementations of a configuration
+   *
+   * @param spec - filter specification
+   */
+  std::vector<Candidate<T>> candidates(const std::string& spec) const {
+    const auto registered{_registered.find(spec)};
+    if (registered != _registered.end()) {
+      return registered->second;
+    }
+
+    std::vector<Candidate<T>> options{
+        {"default", [spec]() { return make_filter<T>(spec); }}};
+    if ((spec.compare(0, 3, "ma:") == 0) &&
+        (spec.find(':', 3) == std::string::npos)) {
+      const int size{std::stoi(spec.substr(3))};
+      options[0].name = "running_sum";
+      options.push_back({"direct_fir", [size]() {
+                           return std::make_unique<FIRFilter<T>>(
+                               std::vector<T>(size, T{1} / size));
+                         }});
+    }
+    return options;
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Costs measured by the last `tune`
+   *
+   */
+  const std::vector<TuneResult>& results() const { return _results; }
+  const FilterProfile& profile() const { return _profile; }
+
+ private:
+  static void check_channels(const int channels) {
+    if (channels < 1) {
+      throw std::domain_error("Number of channels must be positive");
+    }
+  }
+
+  /**
+   * @brief Profile key of a configuration on this CPU
+   *
+   */
+  static std::string key(const std::string& spec, const int channels) {
+    return cpu_signature() + "|" + spec + "|" + std::to_string(channels);
+  }
+
+  /**
+   * @brief The named candidate, or nullptr (e.g. for a stale profile entry)
+   *
+   */
+  static const Candidate<T>* find(const std::vector<Candidate<T>>& options,
+                                  const std::string& name) {
+    for (const auto& option : options) {
+      if (option.name == name) {
+        return &option;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Best time per sample of a candidate over a few runs, filtering one
+   * block per channel in turn
+   *
+   */
+  static double measure(const Candidate<T>& option, const int channels) {
+    constexpr int kRuns{5};
+    const int frames{std::max(256, (1 << 18) / channels)};
+
+    std::vector<std::unique_ptr<Filter<T>>> filters;
+    for (int cc{0}; cc < channels; ++cc) {
+      filters.push_back(option.make());
+    }
+    std::vector<T> data_in(frames);
+    std::vector<T> data_out(frames);
+    for (int ii{0}; ii < frames; ++ii) {
+      data_in[ii] = static_cast<T>(std::sin(0.01 * ii) + 0.1 * std::sin(ii));
+    }
+
+    double best{std::numeric_limits<double>::infinity()};
+    for (int rr{0}; rr <= kRuns; ++rr) {
+      const auto start{std::chrono::steady_clock::now()};
+      for (auto& filter : filters) {
+        filter->filter_block(data_in.data(), data_out.data(), frames);
+      }
+      const auto stop{std::chrono::steady_clock::now()};
+      if (rr > 0) {  // the first run only warms the caches
+        best = std::min(
+            best, std::chrono::duration<double, std::nano>(stop - start)
+                      .count());
+      }
+    }
+    return best / (static_cast<double>(frames) * channels);
+  }
+
+  // VARIABLES *****************************************************************
+
+  FilterProfile _profile;  ///< Saved winners
+  std::map<std::string, std::vector<Candidate<T>>> _registered{};  ///< Custom
+  std::vector<TuneResult> _results{};  ///< Costs from the last `tune`
+};
+
+/**
+ * @brief Build a FilterChain from text specifications, each filter with its
+ * profiled implementation
+ *
+ * @see make_filter_chain
+ *
+ * @tparam T - data type used by the filters
+ * @param tuner - autotuner holding the profile
+ * @param specs - one specification per filter, in order
+ * @param channels - number of channels the chain will run on
+ * @return FilterChain<T>
+ */
+template <typename T>
+FilterChain<T> make_tuned_filter_chain(Autotuner<T>& tuner,
+                                       const std::vector<std::string>& specs,
+                                       const int channels = 1) {
+  FilterChain<T> chain;
+  for (const auto& spec : specs) {
+    chain.add(tuner.make(spec, channels));
+  }
+  return chain;
+}
+
+#endif
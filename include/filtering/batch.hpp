@@ -0,0 +1,382 @@
+/**
+ * @file batch.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Offline filtering of large binary sample files through mmap
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef BATCH_FILTER_HPP
+#define BATCH_FILTER_HPP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "filtering/filter.hpp"
+#include "filtering/multistream.hpp"
+
+/**
+ * @brief Options for filtering sample files
+ *
+ */
+struct BatchOptions {
+  int channels{1};                                 ///< Channels per file
+  SampleLayout layout{SampleLayout::Interleaved};  ///< Channel layout
+  long chunk_frames{1 << 16};  ///< Frames processed between page releases
+  bool huge_pages{true};       ///< Ask for transparent huge pages
+};
+
+// MAPPED FILE *****************************************************************
+
+/**
+ * @brief RAII wrapper around a memory-mapped file
+ *
+ */
+class MappedFile {
+ public:
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Map an existing file read-only, or create and map a file of a
+   * given size read-write.
+   *
+   * @param path - file to map
+   * @param bytes - size of the file to create, or -1 to map an existing file
+   */
+  MappedFile(const std::string& path, const long bytes = -1) {
+    const bool create{bytes >= 0};
+    _fd = create ? ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)
+                 : ::open(path.c_str(), O_RDONLY);
+    if (_fd < 0) {
+      fail("open", path);
+    }
+
+    if (create) {
+      if (::ftruncate(_fd, bytes) != 0) {
+        fail("ftruncate", path);
+      }
+      _size = bytes;
+    } else {
+      struct stat info {};
+      if (::fstat(_fd, &info) != 0) {
+        fail("fstat", path);
+      }
+      _size = info.st_size;
+    }
+
+    if (_size > 0) {
+      const int protection{create ? PROT_READ | PROT_WRITE : PROT_READ};
+      void* data{::mmap(nullptr, _size, protection, MAP_SHARED, _fd, 0)};
+      if (data == MAP_FAILED) {
+        fail("mmap", path);
+      }
+      _data = static_cast<char*>(data);
+    }
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * @brief Unmap and close the file
+   *
+   */
+  ~MappedFile() {
+    if (_data != nullptr) {
+      ::munmap(_data, _size);
+    }
+    if (_fd >= 0) {
+      ::close(_fd);
+    }
+  }
+
+  // MAPPING FUNCTIONS *********************************************************
+
+  /**
+   * @brief Hint that the mapping will be read front to back, and optionally
+   * that it should be backed by huge pages. Hints the kernel rejects are
+   * ignored.
+   *
+   * @param huge_pages - also ask for transparent huge pages
+   */
+  void advise_sequential(const bool huge_pages) {
+    if (_data == nullptr) {
+      return;
+    }
+    ::madvise(_data, _size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    if (huge_pages) {
+      ::madvise(_data, _size, MADV_HUGEPAGE);
+    }
+#endif
+  }
+
+  /**
+   * @brief Tell the kernel a processed byte range is no longer needed, so long
+   * runs don't fill the page cache with data that will not be read again.
+   * Written ranges may be released too: the mapping is shared, so their pages
+   * stay in the page cache until written back.
+   *
+   * @param offset - first byte of the range
+   * @param bytes - length of the range
+   */
+  void release(const long offset, const long bytes) {
+    const long page{::sysconf(_SC_PAGESIZE)};
+    const long begin{offset / page * page};
+    const long end{std::min(offset + bytes, _size) / page * page};
+    if ((_data != nullptr) && (end > begin)) {
+      ::madvise(_data + begin, end - begin, MADV_DONTNEED);
+    }
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Start of the mapping
+   *
+   */
+  char* data() const { return _data; }
+  /**
+   * @brief Size of the mapping [bytes]
+   *
+   */
+  long size() const { return _size; }
+
+ private:
+  /**
+   * @brief Close the file and throw a std::runtime_error describing the
+   * failed system call. Only called from the constructor, where the
+   * destructor will not run.
+   *
+   */
+  [[noreturn]] void fail(const char* call, const std::string& path) {
+    const std::string reason{std::strerror(errno)};
+    if (_fd >= 0) {
+      ::close(_fd);
+    }
+    throw std::runtime_error(std::string{call} + " failed for '" + path +
+                             "': " + reason);
+  }
+
+  // VARIABLES *****************************************************************
+
+  int _fd{-1};           ///< File descriptor
+  char* _data{nullptr};  ///< Start of the mapping
+  long _size{0};         ///< Size of the mapping [bytes]
+};
+
+// FILE IDENTITY ***************************************************************
+
+/**
+ * @brief Identity of the file a path names, which does not depend on how the
+ * path is spelled: the device and inode of the file, or of its directory plus
+ * its name if it does not exist yet
+ *
+ */
+struct FileIdentity {
+  dev_t device{0};     ///< Device of the file or its directory
+  ino_t inode{0};      ///< Inode of the file or its directory
+  std::string name{};  ///< Name in the directory, empty for existing files
+
+  bool operator==(const FileIdentity& other) const {
+    return (device == other.device) && (inode == other.inode) &&
+           (name == other.name);
+  }
+};
+
+/**
+ * @brief Identity of the file a path names
+ *
+ * @param path - existing file, or file to be created in an existing directory
+ */
+inline FileIdentity file_identity(const std::string& path) {
+  struct stat info {};
+  if (::stat(path.c_str(), &info) == 0) {
+    return {info.st_dev, info.st_ino, ""};
+  }
+  const std::size_t slash{path.find_last_of('/')};
+  const std::string directory{
+      slash == std::string::npos ? "." : path.substr(0, slash + 1)};
+  if (::stat(directory.c_str(), &info) != 0) {
+    throw std::runtime_error("Cannot access directory '" + directory +
+                             "': " + std::strerror(errno));
+  }
+  return {info.st_dev, info.st_ino, path.substr(slash + 1)};
+}
+
+// BATCH FILTERING *************************************************************
+
+/**
+ * @brief Filter every channel of a binary sample file into an output file
+ *
+ * The input is a raw array of T (no header) with `options.channels` channels
+ * in `options.layout`. Each channel gets its own clone of `prototype`, and the
+ * output file has the same size and layout as the input. Both files are
+ * memory-mapped; already-processed pages are released as the run progresses.
+ * Interleaved chunks are transposed to planar scratch blocks so that each
+ * channel is filtered with one `filter_block` call per block.
+ *
+ * @throws std::invalid_argument if the output is the input file
+ * @tparam T - sample type stored in the file
+ * @param input_path - file to read
+ * @param output_path - file to create (truncated if it exists)
+ * @param prototype - filter (or FilterChain) applied to each channel
+ * @param options - file layout and mapping options
+ */
+template <typename T>
+void filter_file(const std::string& input_path, const std::string& output_path,
+                 const Filter<T>& prototype, const BatchOptions& options) {
+  if (options.channels < 1) {
+    throw std::domain_error("Number of channels must be positive");
+  }
+
+  if (file_identity(input_path) == file_identity(output_path)) {
+    throw std::invalid_argument("Output '" + output_path +
+                                "' would overwrite input '" + input_path + "'");
+  }
+
+  MappedFile input{input_path};
+  const long frame_bytes{static_cast<long>(sizeof(T)) * options.channels};
+  if (input.size() % frame_bytes != 0) {
+    throw std::runtime_error("'" + input_path +
+                             "' does not hold a whole number of frames");
+  }
+  const long frames{input.size() / frame_bytes};
+  MappedFile output{output_path, input.size()};
+
+  input.advise_sequential(options.huge_pages);
+  output.advise_sequential(options.huge_pages);
+
+  const T* data_in{reinterpret_cast<const T*>(input.data())};
+  T* data_out{reinterpret_cast<T*>(output.data())};
+
+  std::vector<std::unique_ptr<Filter<T>>> filters(options.channels);
+  for (auto& filter : filters) {
+    filter = prototype.clone();
+  }
+
+  // filter_block takes an int count
+  const long chunk{std::clamp(options.chunk_frames, 1L,
+                              long{std::numeric_limits<int>::max()})};
+  if (options.layout == SampleLayout::Planar) {
+    for (int cc{0}; cc < options.channels; ++cc) {
+      const long channel_offset{cc * frames};
+      for (long start{0}; start < frames; start += chunk) {
+        const long count{std::min(chunk, frames - start)};
+        filters[cc]->filter_block(data_in + channel_offset + start,
+                                  data_out + channel_offset + start,
+                                  static_cast<int>(count));
+        input.release((channel_offset + start) * sizeof(T), count * sizeof(T));
+        output.release((channel_offset + start) * sizeof(T),
+                       count * sizeof(T));
+      }
+    }
+  } else {
+    // Blocks of about 16k values, so the planar scratch stays in cache
+    const long block{std::max(1L, (1L << 14) / options.channels)};
+    std::vector<T> planar_in(block * options.channels);
+    std::vector<T> planar_out(block * options.channels);
+    for (long start{0}; start < frames; start += chunk) {
+      const long end{std::min(start + chunk, frames)};
+      for (long first{start}; first < end; first += block) {
+        const int count{static_cast<int>(std::min(block, end - first))};
+        const long offset{first * options.channels};
+        transpose(data_in + offset, planar_in.data(), count, options.channels);
+        for (int cc{0}; cc < options.channels; ++cc) {
+          filters[cc]->filter_block(planar_in.data() + cc * count,
+                                    planar_out.data() + cc * count, count);
+        }
+        transpose(planar_out.data(), data_out + offset, options.channels,
+                  count);
+      }
+      input.release(start * frame_bytes, (end - start) * frame_bytes);
+      output.release(start * frame_bytes, (end - start) * frame_bytes);
+    }
+  }
+}
+
+/**
+ * @brief Filter many files in parallel
+ *
+ * Files are handed out to `threads` workers, each running `filter_file`. If a
+ * file fails, the remaining files are still processed and the first error is
+ * rethrown once all workers have finished.
+ *
+ * @tparam T - sample type stored in the files
+ * @param jobs - (input path, output path) pairs
+ * @param prototype - filter (or FilterChain) applied to each channel
+ * @param options - file layout and mapping options
+ * @param threads - number of worker threads (0 for one per hardware thread)
+ * @throws std::invalid_argument, before any file is written, if two jobs
+ * write the same output or an output is one of the inputs
+ */
+template <typename T>
+void filter_files(const std::vector<std::pair<std::string, std::string>>& jobs,
+                  const Filter<T>& prototype, const BatchOptions& options,
+                  int threads = 0) {
+  std::vector<FileIdentity> inputs;
+  std::vector<FileIdentity> outputs;
+  for (const auto& job : jobs) {
+    inputs.push_back(file_identity(job.first));
+  }
+  for (const auto& job : jobs) {
+    const FileIdentity output{file_identity(job.second)};
+    if ((std::find(outputs.begin(), outputs.end(), output) != outputs.end()) ||
+        (std::find(inputs.begin(), inputs.end(), output) != inputs.end())) {
+      throw std::invalid_argument("Output '" + job.second +
+                                  "' is written twice or is an input");
+    }
+    outputs.push_back(output);
+  }
+
+  if (threads <= 0) {
+    threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  threads = std::min<int>(threads, static_cast<int>(jobs.size()));
+
+  std::atomic<std::size_t> next{0};
+  std::exception_ptr error{nullptr};
+  std::atomic_flag error_set = ATOMIC_FLAG_INIT;
+
+  const auto worker = [&]() {
+    for (std::size_t job{next++}; job < jobs.size(); job = next++) {
+      try {
+        filter_file<T>(jobs[job].first, jobs[job].second, prototype, options);
+      } catch (...) {
+        if (!error_set.test_and_set()) {
+          error = std::current_exception();
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (int ii{0}; ii < threads; ++ii) {
+    workers.emplace_back(worker);
+  }
+  for (auto& thread : workers) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+#endif
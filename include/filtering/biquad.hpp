@@ -0,0 +1,290 @@
+/**
+ * @file biquad.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Higher-order IIR filters as cascades of second-order sections
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef BIQUAD_FILTER_HPP
+#define BIQUAD_FILTER_HPP
+
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "filtering/design.hpp"
+#include "filtering/filter.hpp"
+
+// BIQUAD FILTER ***************************************************************
+
+/**
+ * @brief Set a biquad section to the state it settles in for a constant input
+ *
+ * For a constant x the section output is the DC gain times x,
+ *    y = (b0 + b1 + b2) / (1 + a1 + a2) * x,
+ * and the transposed direct form II update then fixes s1 and s2. The
+ * denominator is positive for any stable section.
+ *
+ * @param c - section coefficients
+ * @param x - constant input of the section
+ * @param s - s1, s2 of the section, set
+ * @return T - the constant output of the section
+ */
+template <typename T>
+constexpr T biquad_steady_state(const BiquadCoefficients<T>& c, const T x,
+                                std::array<T, 2>& s) {
+  const T y{(c.b0 + c.b1 + c.b2) * x / (1 + c.a1 + c.a2)};
+  s[1] = c.b2 * x - c.a2 * y;
+  s[0] = c.b1 * x - c.a1 * y + s[1];
+  return y;
+}
+
+/**
+ * @brief Cascade of biquad sections with coefficients chosen at runtime
+ *
+ * Each section is run in transposed direct form II:
+ *    y = b0*x + s1
+ *    s1 = b1*x - a1*y + s2
+ *    s2 = b2*x - a2*y
+ *
+ * @tparam T - data type used by the filter
+ */
+template <typename T>
+class BiquadFilter : public Filter<T> {
+ public:
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new Biquad Filter object from its sections
+   *
+   * @param sections - coefficients of each section, applied in order
+   */
+  BiquadFilter(const std::vector<BiquadCoefficients<T>>& sections)
+      : _sections{sections}, _state(sections.size()) {
+    if (_sections.empty()) {
+      throw std::domain_error("Biquad filter needs at least one section");
+    }
+    for (const auto& section : _sections) {
+      if (!is_stable(section)) {
+        throw std::domain_error(
+            "Biquad section poles must be inside the unit circle");
+      }
+    }
+  }
+
+  /**
+   * @brief Construct a new Biquad Filter object from a (constexpr) design.
+   * @overload
+   *
+   * @param sections - coefficients of each section, applied in order
+   */
+  template <std::size_t M>
+  BiquadFilter(const std::array<BiquadCoefficients<T>, M>& sections)
+      : BiquadFilter{std::vector<BiquadCoefficients<T>>(sections.begin(),
+                                                        sections.end())} {}
+
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Apply the filter to a new input data point
+   *
+   * @param data_in - newest arrived data point
+   * @param data_out - reference to the output data
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    T x{data_in};
+    for (std::size_t ss{0}; ss < _sections.size(); ++ss) {
+      const BiquadCoefficients<T>& c{_sections[ss]};
+      std::array<T, 2>& s{_state[ss]};
+
+      const T y{c.b0 * x + s[0]};
+      s[0] = c.b1 * x - c.a1 * y + s[1];
+      s[1] = c.b2 * x - c.a2 * y;
+      x = y;
+    }
+    data_out = x;
+  }
+
+  /**
+   * @brief Filter a contiguous block of data points
+   *
+   * The block is run through one section at a time, so each section's
+   * coefficients and state stay in registers over the whole block.
+   *
+   * @param data_in - pointer to the incoming data points
+   * @param data_out - pointer to where the filtered data is written
+   * @param size - number of data points in the block
+   */
+  virtual void filter_block(const T* data_in, T* data_out,
+                            const int size) override {
+    const T* x{data_in};
+    for (std::size_t ss{0}; ss < _sections.size(); ++ss) {
+      const BiquadCoefficients<T> c{_sections[ss]};
+      T s0{_state[ss][0]};
+      T s1{_state[ss][1]};
+      for (int ii{0}; ii < size; ++ii) {
+        const T x_ii{x[ii]};
+        const T y{c.b0 * x_ii + s0};
+        s0 = c.b1 * x_ii - c.a1 * y + s1;
+        s1 = c.b2 * x_ii - c.a2 * y;
+        data_out[ii] = y;
+      }
+      _state[ss] = {s0, s1};
+      x = data_out;
+    }
+  }
+
+  /**
+   * @brief Reset the filter by setting the section states to ZERO
+   *
+   */
+  virtual void reset() override {
+    std::fill(_state.begin(), _state.end(), std::array<T, 2>{});
+  }
+  /**
+   * @brief Start every section at its steady state for a constant input
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override {
+    T x{value};
+    for (std::size_t ss{0}; ss < _sections.size(); ++ss) {
+      x = biquad_steady_state(_sections[ss], x, _state[ss]);
+    }
+  }
+  /**
+   * @brief Set the filter size - NO EFFECT
+   *
+   * The order of the filter is fixed by its sections.
+   *
+   * @param size - the size of the filter
+   */
+  virtual void set_filter_size(const int size) override { return; };
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<BiquadFilter<T>>(*this);
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Coefficients of each section
+   *
+   */
+  const std::vector<BiquadCoefficients<T>>& sections() const {
+    return _sections;
+  }
+
+ private:
+  // VARIABLES *****************************************************************
+
+  std::vector<BiquadCoefficients<T>> _sections;  ///< Section coefficients
+  std::vector<std::array<T, 2>> _state;          ///< s1, s2 of each section
+};
+
+// STATIC BIQUAD FILTER ********************************************************
+
+/**
+ * @brief Cascade of biquad sections fixed at compile time
+ *
+ * The sections are a reference to a constexpr std::array, e.g.
+ *    static constexpr auto kDesign =
+ *        butterworth_low_pass<double, 4>(10.0, 1000.0);
+ *    StaticBiquadFilter<double, kDesign> lp;
+ * so the coefficients are folded into the loop and can live in read-only
+ * memory. An unstable design fails to compile.
+ *
+ * @tparam T - data type used by the filter
+ * @tparam Sections - reference to a constexpr std::array<BiquadCoefficients>
+ */
+template <typename T, const auto& Sections>
+class StaticBiquadFilter : public Filter<T> {
+  static constexpr std::size_t kSections{
+      std::tuple_size<std::decay_t<decltype(Sections)>>::value};
+  static_assert(is_stable(Sections),
+                "Biquad section poles must be inside the unit circle");
+
+ public:
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Apply the filter to a new input data point
+   *
+   * @param data_in - newest arrived data point
+   * @param data_out - reference to the output data
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    T x{data_in};
+    for (std::size_t ss{0}; ss < kSections; ++ss) {
+      std::array<T, 2>& s{_state[ss]};
+
+      const T y{Sections[ss].b0 * x + s[0]};
+      s[0] = Sections[ss].b1 * x - Sections[ss].a1 * y + s[1];
+      s[1] = Sections[ss].b2 * x - Sections[ss].a2 * y;
+      x = y;
+    }
+    data_out = x;
+  }
+
+  /**
+   * @brief Reset the filter by setting the section states to ZERO
+   *
+   */
+  virtual void reset() override { _state = {}; }
+  /**
+   * @brief Start every section at its steady state for a constant input
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override {
+    T x{value};
+    for (std::size_t ss{0}; ss < kSections; ++ss) {
+      x = biquad_steady_state(Sections[ss], x, _state[ss]);
+    }
+  }
+  /**
+   * @brief Set the filter size - NO EFFECT
+   *
+   * The order of the filter is fixed by its sections.
+   *
+   * @param size - the size of the filter
+   */
+  virtual void set_filter_size(const int size) override { return; };
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<StaticBiquadFilter<T, Sections>>(*this);
+  }
+
+ private:
+  // VARIABLES *****************************************************************
+
+  std::array<std::array<T, 2>, kSections> _state{};  ///< s1, s2 per section
+};
+
+// EXPLICIT INSTANTIATIONS *****************************************************
+
+/**
+ * @brief Compiled into filtering_static/filtering_shared, see filter.hpp
+ *
+ */
+#ifdef FILTERING_EXTERN_TEMPLATES
+extern template class BiquadFilter<float>;
+extern template class BiquadFilter<double>;
+#endif
+
+#endif
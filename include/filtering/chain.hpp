@@ -0,0 +1,312 @@
+/**
+ * @file chain.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Filters applied in series, and a text format to configure them
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef FILTER_CHAIN_HPP
+#define FILTER_CHAIN_HPP
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "filtering/filter.hpp"
+#include "filtering/savgol.hpp"
+#include "filtering/statistics.hpp"
+
+// FILTER CHAIN ****************************************************************
+
+/**
+ * @brief A series of filters, each fed the output of the previous one
+ *
+ * The chain is itself a Filter, so it can be cloned into a MultiStreamFilter
+ * or handed to anything else that takes a Filter<T>.
+ *
+ * @tparam T - data type used by the filters
+ */
+template <typename T>
+class FilterChain : public Filter<T> {
+ public:
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct an empty Filter Chain object, which passes data through
+   *
+   */
+  FilterChain() = default;
+
+  /**
+   * @brief Copy a Filter Chain object by cloning each of its filters
+   *
+   * @param other - chain to copy
+   */
+  FilterChain(const FilterChain<T>& other) {
+    for (const auto& filter : other._filters) {
+      _filters.push_back(filter->clone());
+    }
+  }
+
+  /**
+   * @brief Append a copy of a filter to the end of the chain
+   *
+   * @param filter - an anonymous object of any Filter sub-type.
+   * @return FilterChain<T>& - the chain, to allow chaining calls
+   */
+  FilterChain<T>& add(Filter<T> const& filter) {
+    _filters.push_back(filter.clone());
+    return *this;
+  }
+
+  /**
+   * @brief Append a filter to the end of the chain. @overload
+   *
+   * @param filter - unique_ptr to the filter
+   * @return FilterChain<T>& - the chain, to allow chaining calls
+   */
+  FilterChain<T>& add(std::unique_ptr<Filter<T>> filter) {
+    _filters.push_back(std::move(filter));
+    return *this;
+  }
+
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Apply every filter in turn to a new input data point
+   *
+   * @param data_in - newest arrived data point
+   * @param data_out - reference to the output of the last filter
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    T data{data_in};
+    for (auto& filter : _filters) {
+      filter->filter(data, data);
+    }
+    data_out = data;
+  }
+
+  /**
+   * @brief Apply every filter in turn to a block of data
+   *
+   * @param data_in - pointer to the incoming data points
+   * @param data_out - pointer to where the filtered data is written
+   * @param size - number of data points in the block
+   */
+  virtual void filter_block(const T* data_in, T* data_out,
+                            const int size) override {
+    if (_filters.empty()) {
+      std::copy(data_in, data_in + size, data_out);
+      return;
+    }
+    _filters[0]->filter_block(data_in, data_out, size);
+    for (std::size_t ii{1}; ii < _filters.size(); ++ii) {
+      _scratch.assign(data_out, data_out + size);
+      _filters[ii]->filter_block(_scratch.data(), data_out, size);
+    }
+  }
+
+  /**
+   * @brief Reset every filter in the chain
+   *
+   */
+  virtual void reset() override {
+    for (auto& filter : _filters) {
+      filter->reset();
+    }
+  }
+
+  /**
+   * @brief Seed every filter in the chain with the steady output of the
+   * filter before it
+   *
+   * A seeded filter is at a fixed point for its constant input, so filtering
+   * that input once more gives its steady output without changing its state.
+   *
+   * @param value - the constant input the chain is settled on
+   */
+  virtual void seed(const T value) override {
+    T x{value};
+    for (auto& filter : _filters) {
+      filter->seed(x);
+      filter->filter(x, x);
+    }
+  }
+
+  /**
+   * @brief Set the filter size of every filter in the chain
+   *
+   * @param size - how many data points does each filter consider?
+   */
+  virtual void set_filter_size(const int size) override {
+    for (auto& filter : _filters) {
+      filter->set_filter_size(size);
+    }
+  }
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<FilterChain<T>>(*this);
+  }
+
+  /**
+   * @brief Number of filters in the chain
+   *
+   */
+  int size() const { return static_cast<int>(_filters.size()); }
+
+ private:
+  // VARIABLES *****************************************************************
+
+  std::vector<std::unique_ptr<Filter<T>>> _filters{};  ///< Filters, in order
+  std::vector<T> _scratch{};  ///< Intermediate block between two filters
+};
+
+// FILTER SPECIFICATIONS *******************************************************
+
+/**
+ * @brief Build a filter from a text specification
+ *
+ * Specifications are a name followed by colon-separated parameters:
+ *    exp:ALPHA                          ExponentialFilter
+ *    ma:SIZE[:WARMUP]                   MovingAverageFilter, WARMUP is one
+ *                                       of zeros (default), partial, first
+ *    lp:RC:DT                           LowPassFilter
+ *    hp:RC:DT                           HighPassFilter
+ *    sg:WINDOW:ORDER[:DERIVATIVE[:DT]]  SavitzkyGolayFilter
+ *    ewstat:ALPHA:STATISTIC             EWStatisticsFilter, STATISTIC is one
+ *                                       of mean, var, std, z
+ *    wstat:SIZE:STATISTIC               WindowedStatisticsFilter, as ewstat
+ *                                       or skew, kurt
+ * which lets command line tools and configuration files pick filters.
+ *
+ * @tparam T - data type used by the filter
+ * @param spec - the specification, e.g. "exp:0.1"
+ * @return std::unique_ptr<Filter<T>>
+ */
+template <typename T>
+std::unique_ptr<Filter<T>> make_filter(const std::string& spec) {
+  std::vector<std::string> fields;
+  std::stringstream stream{spec};
+  for (std::string field; std::getline(stream, field, ':');) {
+    fields.push_back(field);
+  }
+
+  const auto expect = [&](const std::size_t min, const std::size_t max) {
+    if ((fields.size() < min + 1) || (fields.size() > max + 1)) {
+      throw std::invalid_argument("Wrong number of parameters in filter '" +
+                                  spec + "'");
+    }
+  };
+  const auto number = [&](const std::size_t ind) {
+    return static_cast<T>(std::stod(fields[ind]));
+  };
+  const auto integer = [&](const std::size_t ind) {
+    return std::stoi(fields[ind]);
+  };
+  const auto statistic = [&](const std::size_t ind) {
+    const std::string& name{fields[ind]};
+    if (name == "mean") {
+      return Statistic::Mean;
+    }
+    if (name == "var") {
+      return Statistic::Variance;
+    }
+    if (name == "std") {
+      return Statistic::StdDev;
+    }
+    if (name == "z") {
+      return Statistic::ZScore;
+    }
+    if (name == "skew") {
+      return Statistic::Skewness;
+    }
+    if (name == "kurt") {
+      return Statistic::Kurtosis;
+    }
+    throw std::invalid_argument("Unknown statistic in filter '" + spec + "'");
+  };
+
+  const std::string name{fields.empty() ? "" : fields[0]};
+  if (name == "exp") {
+    expect(1, 1);
+    return std::make_unique<ExponentialFilter<T>>(number(1));
+  }
+  if (name == "ma") {
+    expect(1, 2);
+    const std::string warm_up{fields.size() > 2 ? fields[2] : "zeros"};
+    if ((warm_up != "zeros") && (warm_up != "partial") &&
+        (warm_up != "first")) {
+      throw std::invalid_argument("Unknown warm-up in filter '" + spec + "'");
+    }
+    return std::make_unique<MovingAverageFilter<T>>(
+        integer(1), warm_up == "zeros"     ? WarmUp::Zeros
+                    : warm_up == "partial" ? WarmUp::Partial
+                                           : WarmUp::FirstSample);
+  }
+  if (name == "lp") {
+    expect(2, 2);
+    return std::make_unique<LowPassFilter<T>>(number(1), number(2));
+  }
+  if (name == "hp") {
+    expect(2, 2);
+    return std::make_unique<HighPassFilter<T>>(number(1), number(2));
+  }
+  if (name == "sg") {
+    expect(2, 4);
+    return std::make_unique<SavitzkyGolayFilter<T>>(
+        integer(1), integer(2), fields.size() > 3 ? integer(3) : 0,
+        fields.size() > 4 ? number(4) : T{1});
+  }
+  if (name == "ewstat") {
+    expect(2, 2);
+    return std::make_unique<EWStatisticsFilter<T>>(number(1), statistic(2));
+  }
+  if (name == "wstat") {
+    expect(2, 2);
+    return std::make_unique<WindowedStatisticsFilter<T>>(integer(1),
+                                                          statistic(2));
+  }
+  throw std::invalid_argument("Unknown filter '" + spec + "'");
+}
+
+/**
+ * @brief Build a FilterChain from a list of text specifications
+ *
+ * @see make_filter
+ *
+ * @tparam T - data type used by the filters
+ * @param specs - one specification per filter, in order
+ * @return FilterChain<T>
+ */
+template <typename T>
+FilterChain<T> make_filter_chain(const std::vector<std::string>& specs) {
+  FilterChain<T> chain;
+  for (const auto& spec : specs) {
+    chain.add(make_filter<T>(spec));
+  }
+  return chain;
+}
+
+// EXPLICIT INSTANTIATIONS *****************************************************
+
+/**
+ * @brief Compiled into filtering_static/filtering_shared, see filter.hpp
+ *
+ */
+#ifdef FILTERING_EXTERN_TEMPLATES
+extern template class FilterChain<float>;
+extern template class FilterChain<double>;
+#endif
+
+#endif
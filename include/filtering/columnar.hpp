@@ -0,0 +1,345 @@
+/**
+ * @file columnar.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Filter columnar (Apache Arrow layout) batches without copying
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef COLUMNAR_FILTER_HPP
+#define COLUMNAR_FILTER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "filtering/filter.hpp"
+#include "filtering/multistream.hpp"
+
+// COLUMN LAYOUT ***************************************************************
+
+/**
+ * @brief Read-only view of a primitive column in the Arrow memory layout
+ *
+ * `values` is the contiguous value buffer and `validity` the optional validity
+ * bitmap (bit i set means entry i is valid, least-significant bit first, a
+ * null pointer means every entry is valid). `offset` is the index of the
+ * first entry in both buffers, as in an Arrow array slice. The buffers of an
+ * Arrow PrimitiveArray can be passed straight in, e.g. from C++ Arrow:
+ *    ColumnView<double>{array.raw_values() - array.offset(),
+ *                       array.null_bitmap_data(), array.length(),
+ *                       array.offset()}
+ *
+ * @tparam T - value type of the column
+ */
+template <typename T>
+struct ColumnView {
+  const T* values{nullptr};               ///< Value buffer
+  const std::uint8_t* validity{nullptr};  ///< Validity bitmap, or nullptr
+  std::int64_t length{0};                 ///< Number of entries
+  std::int64_t offset{0};                 ///< Index of the first entry
+};
+
+/**
+ * @brief Writable view of a primitive column in the Arrow memory layout
+ *
+ * @see ColumnView
+ *
+ * @tparam T - value type of the column
+ */
+template <typename T>
+struct MutableColumnView {
+  T* values{nullptr};               ///< Value buffer
+  std::uint8_t* validity{nullptr};  ///< Validity bitmap, or nullptr
+  std::int64_t length{0};           ///< Number of entries
+  std::int64_t offset{0};           ///< Index of the first entry
+};
+
+/**
+ * @brief What to do with null entries in a column
+ *
+ * Skip: nulls are not fed to the filter and stay null in the output.
+ * Hold: nulls are replaced by the last valid input, so the output is valid
+ *       from the first valid entry on.
+ */
+enum class NullPolicy { Skip, Hold };
+
+// BITMAP SUPPORT FUNCTIONS ****************************************************
+
+/**
+ * @brief Is bit `ind` of an LSB-first bitmap set?
+ *
+ */
+inline bool get_bit(const std::uint8_t* bits, const std::int64_t ind) {
+  return (bits[ind >> 3] >> (ind & 7)) & 1;
+}
+
+/**
+ * @brief Set bits [begin, end) of an LSB-first bitmap to a value
+ *
+ */
+inline void set_bits(std::uint8_t* bits, std::int64_t begin,
+                     const std::int64_t end, const bool value) {
+  for (; (begin < end) && (begin & 7); ++begin) {
+    bits[begin >> 3] = value ? bits[begin >> 3] | (1 << (begin & 7))
+                             : bits[begin >> 3] & ~(1 << (begin & 7));
+  }
+  const std::int64_t whole{(end - begin) >> 3};
+  if (whole > 0) {
+    std::memset(bits + (begin >> 3), value ? 0xFF : 0x00, whole);
+    begin += whole << 3;
+  }
+  for (; begin < end; ++begin) {
+    bits[begin >> 3] = value ? bits[begin >> 3] | (1 << (begin & 7))
+                             : bits[begin >> 3] & ~(1 << (begin & 7));
+  }
+}
+
+/**
+ * @brief Index of the first entry in [begin, end) whose bit differs from
+ * `value`, or `end`. Whole bytes are skipped at once.
+ *
+ */
+inline std::int64_t find_bit_change(const std::uint8_t* bits,
+                                    std::int64_t begin, const std::int64_t end,
+                                    const bool value) {
+  const std::uint8_t same{static_cast<std::uint8_t>(value ? 0xFF : 0x00)};
+  while (begin < end) {
+    if (((begin & 7) == 0) && (begin + 8 <= end) &&
+        (bits[begin >> 3] == same)) {
+      begin += 8;
+    } else if (get_bit(bits, begin) == value) {
+      ++begin;
+    } else {
+      return begin;
+    }
+  }
+  return end;
+}
+
+// COLUMN FILTER ***************************************************************
+
+/**
+ * @brief Apply a filter to a sequence of column batches
+ *
+ * Runs of valid entries are handed to the filter's `filter_block` directly on
+ * the column buffers, so a column without nulls is filtered in a single block
+ * call with no copy. The filter state (and the last valid value, for
+ * NullPolicy::Hold) carries over from one batch to the next.
+ *
+ * @tparam T - value type of the column
+ */
+template <typename T>
+class ColumnFilter {
+ public:
+  // CONSTRUCTOR ***************************************************************
+
+  /**
+   * @brief Construct a new Column Filter object from any type of Filter
+   *
+   * @param filter - an anonymous object of any Filter sub-type.
+   * @param policy - handling of null entries
+   */
+  ColumnFilter(Filter<T> const& filter,
+               const NullPolicy policy = NullPolicy::Skip)
+      : _filter{filter.clone()}, _policy{policy} {}
+
+  // FILTER FUNCTIONS **********************************************************
+
+  /**
+   * @brief Filter one batch of a column
+   *
+   * @param data_in - the input column
+   * @param data_out - the output column, of the same length. Its validity
+   * bitmap may only be omitted if the input has no nulls.
+   */
+  void filter(const ColumnView<T>& data_in,
+              const MutableColumnView<T>& data_out) {
+    filter_column(*_filter, data_in, data_out, _policy, _last_valid,
+                  _has_last_valid);
+  }
+
+  /**
+   * @brief Reset the filter and forget the last valid value
+   *
+   */
+  void reset() {
+    _filter->reset();
+    _has_last_valid = false;
+  }
+
+  // STATIC FILTER FUNCTIONS ***************************************************
+
+  /**
+   * @brief Filter one batch of a column with an external filter and hold state
+   *
+   * @param filter - filter to apply
+   * @param data_in - the input column
+   * @param data_out - the output column
+   * @param policy - handling of null entries
+   * @param last_valid - last valid input seen, updated
+   * @param has_last_valid - whether `last_valid` has been set, updated
+   */
+  static void filter_column(Filter<T>& filter, const ColumnView<T>& data_in,
+                            const MutableColumnView<T>& data_out,
+                            const NullPolicy policy, T& last_valid,
+                            bool& has_last_valid) {
+    if (data_out.length != data_in.length) {
+      throw std::invalid_argument("Input and output columns differ in length");
+    }
+    const std::int64_t length{data_in.length};
+    const T* values_in{data_in.values + data_in.offset};
+    T* values_out{data_out.values + data_out.offset};
+
+    if (data_in.validity == nullptr) {
+      filter_run(filter, values_in, values_out, length);
+      if (length > 0) {
+        last_valid = values_in[length - 1];
+        has_last_valid = true;
+      }
+      if (data_out.validity != nullptr) {
+        set_bits(data_out.validity, data_out.offset, data_out.offset + length,
+                 true);
+      }
+      return;
+    }
+    if (data_out.validity == nullptr) {
+      throw std::invalid_argument(
+          "Output column needs a validity bitmap when the input has one");
+    }
+
+    std::int64_t begin{0};
+    while (begin < length) {
+      const std::int64_t in_begin{data_in.offset + begin};
+      const bool valid{get_bit(data_in.validity, in_begin)};
+      const std::int64_t end{
+          find_bit_change(data_in.validity, in_begin,
+                          data_in.offset + length, valid) -
+          data_in.offset};
+
+      if (valid) {
+        filter_run(filter, values_in + begin, values_out + begin, end - begin);
+        last_valid = values_in[end - 1];
+        has_last_valid = true;
+        set_bits(data_out.validity, data_out.offset + begin,
+                 data_out.offset + end, true);
+      } else if ((policy == NullPolicy::Hold) && has_last_valid) {
+        for (std::int64_t ii{begin}; ii < end; ++ii) {
+          filter.filter(last_valid, values_out[ii]);
+        }
+        set_bits(data_out.validity, data_out.offset + begin,
+                 data_out.offset + end, true);
+      } else {
+        std::fill(values_out + begin, values_out + end, T{0});
+        set_bits(data_out.validity, data_out.offset + begin,
+                 data_out.offset + end, false);
+      }
+      begin = end;
+    }
+  }
+
+ private:
+  /**
+   * @brief Filter a run of valid entries, split into int-sized blocks
+   *
+   */
+  static void filter_run(Filter<T>& filter, const T* data_in, T* data_out,
+                         std::int64_t size) {
+    constexpr std::int64_t kMaxBlock{1 << 30};
+    while (size > 0) {
+      const int block{static_cast<int>(size < kMaxBlock ? size : kMaxBlock)};
+      filter.filter_block(data_in, data_out, block);
+      data_in += block;
+      data_out += block;
+      size -= block;
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  std::unique_ptr<Filter<T>> _filter;  ///< Filter applied to the column
+  NullPolicy _policy;                  ///< Handling of null entries
+  T _last_valid{0};                    ///< Last valid input seen
+  bool _has_last_valid{false};         ///< Has a valid input been seen?
+};
+
+// RECORD BATCH FILTER *********************************************************
+
+/**
+ * @brief Apply a MultiStreamFilter to N columns of a record batch
+ *
+ * Column ii is filtered by stream ii of the MultiStreamFilter, one column at a
+ * time, using the same zero-copy run handling as ColumnFilter.
+ *
+ * @tparam T - value type of the columns
+ * @tparam N - number of columns
+ */
+template <typename T, int N>
+class RecordBatchFilter {
+ public:
+  // CONSTRUCTOR ***************************************************************
+
+  /**
+   * @brief Construct a new Record Batch Filter object from any type of Filter
+   *
+   * @param filter - an anonymous object of any Filter sub-type.
+   * @param policy - handling of null entries
+   */
+  RecordBatchFilter(Filter<T> const& filter,
+                    const NullPolicy policy = NullPolicy::Skip)
+      : _filters{filter}, _policy{policy} {}
+
+  /**
+   * @brief Construct a new Record Batch Filter object from an array of
+   * filters. @overload
+   *
+   * @param filters - a std::array of unique_ptrs to filters.
+   * @param policy - handling of null entries
+   */
+  RecordBatchFilter(std::array<std::unique_ptr<Filter<T>>, N> filters,
+                    const NullPolicy policy = NullPolicy::Skip)
+      : _filters{std::move(filters)}, _policy{policy} {}
+
+  // FILTER FUNCTIONS **********************************************************
+
+  /**
+   * @brief Filter one record batch
+   *
+   * @param data_in - the input columns
+   * @param data_out - the output columns
+   */
+  void filter(const std::array<ColumnView<T>, N>& data_in,
+              const std::array<MutableColumnView<T>, N>& data_out) {
+    for (int ii{0}; ii < N; ++ii) {
+      bool has_last_valid{_has_last_valid[ii]};
+      ColumnFilter<T>::filter_column(_filters.stream(ii), data_in[ii],
+                                     data_out[ii], _policy, _last_valid[ii],
+                                     has_last_valid);
+      _has_last_valid[ii] = has_last_valid;
+    }
+  }
+
+  /**
+   * @brief Reset the filters and forget the last valid values
+   *
+   */
+  void reset() {
+    _filters.reset();
+    _has_last_valid.fill(false);
+  }
+
+ private:
+  // VARIABLES *****************************************************************
+
+  MultiStreamFilter<T, N> _filters;       ///< One filter per column
+  NullPolicy _policy;                     ///< Handling of null entries
+  std::array<T, N> _last_valid{};         ///< Last valid input per column
+  std::array<bool, N> _has_last_valid{};  ///< Valid input seen per column?
+};
+
+#endif
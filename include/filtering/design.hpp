@@ -0,0 +1,285 @@
+/**
+ * @file design.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Compile-time (constexpr) filter design
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef FILTER_DESIGN_HPP
+#define FILTER_DESIGN_HPP
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+
+// CONSTEXPR MATH **************************************************************
+
+/**
+ * @brief Minimal constexpr replacements for <cmath>, which is not constexpr
+ * before C++26. Accurate to a few ulp over the ranges used by the designs.
+ *
+ */
+namespace filtering_detail {
+
+constexpr long double kPi{3.141592653589793238462643383279502884L};
+
+/**
+ * @brief Sine via range reduction to [-pi, pi] and a Taylor series
+ *
+ */
+template <typename T>
+constexpr T sin(const T x) {
+  const long double turns{x / (2 * kPi)};
+  const long long whole{static_cast<long long>(turns < 0 ? turns - 0.5L
+                                                         : turns + 0.5L)};
+  const long double r{x - whole * 2 * kPi};
+
+  long double term{r};
+  long double sum{r};
+  for (int nn{1}; nn < 40; ++nn) {
+    term *= -r * r / ((2 * nn) * (2 * nn + 1));
+    sum += term;
+  }
+  return static_cast<T>(sum);
+}
+
+/**
+ * @brief Cosine as a shifted sine
+ *
+ */
+template <typename T>
+constexpr T cos(const T x) {
+  return static_cast<T>(sin<long double>(x + kPi / 2));
+}
+
+/**
+ * @brief Tangent as sine over cosine
+ *
+ */
+template <typename T>
+constexpr T tan(const T x) {
+  return static_cast<T>(sin<long double>(x) / cos<long double>(x));
+}
+
+/**
+ * @brief Absolute value
+ *
+ */
+template <typename T>
+constexpr T abs(const T x) {
+  return x < 0 ? -x : x;
+}
+
+}  // namespace filtering_detail
+
+// COEFFICIENT TYPES ***********************************************************
+
+/**
+ * @brief Coefficients of one second-order (biquad) section
+ *
+ * The section implements (for x in and y out):
+ *    y[k] = b0*x[k] + b1*x[k-1] + b2*x[k-2] - a1*y[k-1] - a2*y[k-2]
+ * A first-order section simply has b2 = a2 = 0.
+ *
+ * @tparam T - data type of the coefficients
+ */
+template <typename T>
+struct BiquadCoefficients {
+  T b0{1};
+  T b1{0};
+  T b2{0};
+  T a1{0};
+  T a2{0};
+};
+
+// DESIGN CHECKS ***************************************************************
+
+/**
+ * @brief Is an exponential filter constant valid, i.e. in (0, 1]?
+ *
+ */
+template <typename T>
+constexpr bool is_valid_filter_constant(const T filter_constant) {
+  return (filter_constant > 0) && (filter_constant <= 1);
+}
+
+/**
+ * @brief Are both poles of a biquad section strictly inside the unit circle?
+ *
+ */
+template <typename T>
+constexpr bool is_stable(const BiquadCoefficients<T>& section) {
+  return (filtering_detail::abs(section.a2) < 1) &&
+         (filtering_detail::abs(section.a1) < 1 + section.a2);
+}
+
+/**
+ * @brief Is every section of a biquad cascade stable?
+ *
+ */
+template <typename T, std::size_t M>
+constexpr bool is_stable(const std::array<BiquadCoefficients<T>, M>& sections) {
+  for (const auto& section : sections) {
+    if (!is_stable(section)) {
+      return false;
+    }
+  }
+  return M > 0;
+}
+
+// FIRST-ORDER DESIGNS *********************************************************
+
+/**
+ * @brief Filter constant of a LowPassFilter with a given -3dB cutoff
+ *
+ * Equivalent to the LowPassFilter(RC, dt) constructor with RC = 1/(2*pi*fc)
+ * and dt = 1/fs, but usable in constant expressions.
+ *
+ * @param cutoff - cutoff frequency [Hz]
+ * @param sample_rate - frequency at which new data arrives [Hz]
+ */
+template <typename T>
+constexpr T low_pass_constant(const T cutoff, const T sample_rate) {
+  const T rc{static_cast<T>(1 / (2 * filtering_detail::kPi * cutoff))};
+  const T dt{1 / sample_rate};
+  return dt / (rc + dt);
+}
+
+/**
+ * @brief Filter constant of a HighPassFilter with a given -3dB cutoff
+ *
+ * Equivalent to the HighPassFilter(RC, dt) constructor with RC = 1/(2*pi*fc)
+ * and dt = 1/fs, but usable in constant expressions.
+ *
+ * @param cutoff - cutoff frequency [Hz]
+ * @param sample_rate - frequency at which new data arrives [Hz]
+ */
+template <typename T>
+constexpr T high_pass_constant(const T cutoff, const T sample_rate) {
+  const T rc{static_cast<T>(1 / (2 * filtering_detail::kPi * cutoff))};
+  const T dt{1 / sample_rate};
+  return rc / (rc + dt);
+}
+
+// BUTTERWORTH DESIGNS *********************************************************
+
+/**
+ * @brief Butterworth low- or high-pass design as a cascade of biquads
+ *
+ * Uses the bilinear transform with pre-warping. An odd order ends with a
+ * first-order section.
+ *
+ * @tparam T - data type of the coefficients
+ * @tparam Order - filter order (>= 1)
+ * @param cutoff - -3dB frequency [Hz], in (0, sample_rate/2)
+ * @param sample_rate - frequency at which new data arrives [Hz]
+ * @param high_pass - design a high-pass rather than a low-pass filter
+ */
+template <typename T, int Order>
+constexpr std::array<BiquadCoefficients<T>, (Order + 1) / 2> butterworth(
+    const T cutoff, const T sample_rate, const bool high_pass) {
+  static_assert(Order >= 1, "Butterworth order must be at least 1");
+  if ((cutoff <= 0) || (2 * cutoff >= sample_rate)) {
+    throw std::domain_error("Cutoff must be in the range (0, sample_rate/2)");
+  }
+
+  const T k{filtering_detail::tan<T>(
+      static_cast<T>(filtering_detail::kPi * cutoff / sample_rate))};
+  std::array<BiquadCoefficients<T>, (Order + 1) / 2> sections{};
+
+  for (int ss{0}; ss < Order / 2; ++ss) {
+    const T inv_q{2 * filtering_detail::sin<T>(static_cast<T>(
+                          (2 * ss + 1) * filtering_detail::kPi / (2 * Order)))};
+    const T norm{1 / (1 + k * inv_q + k * k)};
+    BiquadCoefficients<T>& section{sections[ss]};
+    if (high_pass) {
+      section.b0 = norm;
+      section.b1 = -2 * norm;
+    } else {
+      section.b0 = k * k * norm;
+      section.b1 = 2 * section.b0;
+    }
+    section.b2 = section.b0;
+    section.a1 = 2 * (k * k - 1) * norm;
+    section.a2 = (1 - k * inv_q + k * k) * norm;
+  }
+
+  if (Order % 2 == 1) {
+    const T norm{1 / (1 + k)};
+    BiquadCoefficients<T>& section{sections[Order / 2]};
+    section.b0 = high_pass ? norm : k * norm;
+    section.b1 = high_pass ? -norm : k * norm;
+    section.a1 = (k - 1) * norm;
+  }
+  return sections;
+}
+
+/**
+ * @brief Butterworth low-pass design. @see butterworth
+ *
+ */
+template <typename T, int Order>
+constexpr std::array<BiquadCoefficients<T>, (Order + 1) / 2>
+butterworth_low_pass(const T cutoff, const T sample_rate) {
+  return butterworth<T, Order>(cutoff, sample_rate, false);
+}
+
+/**
+ * @brief Butterworth high-pass design. @see butterworth
+ *
+ */
+template <typename T, int Order>
+constexpr std::array<BiquadCoefficients<T>, (Order + 1) / 2>
+butterworth_high_pass(const T cutoff, const T sample_rate) {
+  return butterworth<T, Order>(cutoff, sample_rate, true);
+}
+
+// FIR DESIGNS *****************************************************************
+
+/**
+ * @brief Windowed-sinc low-pass FIR design (Hamming window, unity DC gain)
+ *
+ * @tparam T - data type of the taps
+ * @tparam Taps - number of taps (odd gives an integer group delay)
+ * @param cutoff - -6dB frequency [Hz], in (0, sample_rate/2)
+ * @param sample_rate - frequency at which new data arrives [Hz]
+ * @return std::array<T, Taps> - the taps, oldest point first
+ */
+template <typename T, int Taps>
+constexpr std::array<T, Taps> fir_low_pass(const T cutoff,
+                                           const T sample_rate) {
+  static_assert(Taps >= 1, "FIR filter needs at least one tap");
+  if ((cutoff <= 0) || (2 * cutoff >= sample_rate)) {
+    throw std::domain_error("Cutoff must be in the range (0, sample_rate/2)");
+  }
+
+  const long double fc{cutoff / static_cast<long double>(sample_rate)};
+  const long double centre{(Taps - 1) / 2.0L};
+  std::array<T, Taps> taps{};
+
+  long double sum{0};
+  for (int nn{0}; nn < Taps; ++nn) {
+    const long double t{nn - centre};
+    const long double sinc{
+        t == 0 ? 2 * fc
+               : filtering_detail::sin<long double>(2 * filtering_detail::kPi *
+                                                    fc * t) /
+                     (filtering_detail::kPi * t)};
+    const long double window{
+        Taps == 1 ? 1
+                  : 0.54L - 0.46L * filtering_detail::cos<long double>(
+                                        2 * filtering_detail::kPi * nn /
+                                        (Taps - 1))};
+    taps[nn] = static_cast<T>(sinc * window);
+    sum += sinc * window;
+  }
+  for (auto& tap : taps) {
+    tap = static_cast<T>(tap / sum);
+  }
+  return taps;
+}
+
+#endif
@@ -0,0 +1,371 @@
+/**
+ * @file dispatch.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Runtime selection of instruction-set specific filter kernels
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef DISPATCH_FILTER_HPP
+#define DISPATCH_FILTER_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FILTERING_DISPATCH_X86
+#define FILTERING_TARGET(isa) __attribute__((target(isa)))
+#endif
+#if defined(__GNUC__)
+#define FILTERING_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define FILTERING_ALWAYS_INLINE inline
+#endif
+// Clang turns contraction off with a pragma in the kernel bodies instead
+#if defined(__GNUC__) && !defined(__clang__)
+#define FILTERING_NO_CONTRACT __attribute__((optimize("fp-contract=off")))
+#else
+#define FILTERING_NO_CONTRACT
+#endif
+
+// INSTRUCTION SETS ************************************************************
+
+/**
+ * @brief Instruction sets with their own kernel variants
+ *
+ * On x86 each variant is the same loop compiled for that instruction set with
+ * a target attribute, so one binary runs the widest vectors each machine has
+ * whatever flags it was built with. NEON is part of the AArch64 baseline, so
+ * there the generic kernels already use it.
+ *
+ * The kernels are compiled without floating point contraction, so the FMA
+ * units of the wider variants never fuse a multiply-add the narrower ones
+ * round twice: every variant gives bit for bit the same outputs, whatever
+ * the CPU or FILTERING_ISA.
+ */
+enum class Isa { Generic, SSE2, AVX2, AVX512, NEON };
+
+/**
+ * @brief Name of an instruction set, as accepted by FILTERING_ISA
+ *
+ */
+inline const char* isa_name(const Isa isa) {
+  switch (isa) {
+    case Isa::SSE2:
+      return "sse2";
+    case Isa::AVX2:
+      return "avx2";
+    case Isa::AVX512:
+      return "avx512";
+    case Isa::NEON:
+      return "neon";
+    default:
+      return "generic";
+  }
+}
+
+/**
+ * @brief Can this CPU run the kernels of an instruction set?
+ *
+ */
+inline bool isa_supported(const Isa isa) {
+  switch (isa) {
+    case Isa::Generic:
+      return true;
+#ifdef FILTERING_DISPATCH_X86
+    case Isa::SSE2:
+      return __builtin_cpu_supports("sse2");
+    case Isa::AVX2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case Isa::AVX512:
+      return __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("avx512vl");
+#endif
+#if defined(__aarch64__) || defined(__ARM_NEON)
+    case Isa::NEON:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief The widest instruction set this CPU supports
+ *
+ */
+inline Isa best_isa() {
+  for (const Isa isa : {Isa::AVX512, Isa::AVX2, Isa::SSE2, Isa::NEON}) {
+    if (isa_supported(isa)) {
+      return isa;
+    }
+  }
+  return Isa::Generic;
+}
+
+/**
+ * @brief Instruction set used by the dispatched kernels, chosen once per
+ * process
+ *
+ * Set the environment variable FILTERING_ISA to generic, sse2, avx2, avx512
+ * or neon to force a narrower path for testing. Requests the CPU cannot run,
+ * and unknown names, fall back to `best_isa()`.
+ */
+inline Isa active_isa() {
+  static const Isa isa{[]() {
+    const char* requested{std::getenv("FILTERING_ISA")};
+    if (requested != nullptr) {
+      for (const Isa candidate : {Isa::Generic, Isa::SSE2, Isa::AVX2,
+                                  Isa::AVX512, Isa::NEON}) {
+        if ((requested == std::string{isa_name(candidate)}) &&
+            isa_supported(candidate)) {
+          return candidate;
+        }
+      }
+    }
+    return best_isa();
+  }()};
+  return isa;
+}
+
+// FIR CONVOLUTION KERNEL ******************************************************
+
+/**
+ * @brief Direct FIR convolution of a block:
+ *    data_out[ii] = taps[0]*data_in[ii] + ... + taps[M-1]*data_in[ii+M-1]
+ *
+ * The loop over taps is outside the loop over outputs, so the inner loop is
+ * an element-wise multiply-add across outputs that vectorizes without
+ * reordering any sum. Taps are taken eight at a time so each output is only
+ * loaded and stored once per eight taps, and outputs are done in tiles that
+ * stay in L1 cache.
+ *
+ */
+template <typename T>
+FILTERING_ALWAYS_INLINE FILTERING_NO_CONTRACT void fir_convolve_kernel(
+    const T* taps, const int window, const T* data_in, T* data_out,
+    const int size) {
+#ifdef __clang__
+#pragma clang fp contract(off)
+#endif
+  constexpr int kTile{256};
+  constexpr int kTaps{8};
+  for (int i0{0}; i0 < size; i0 += kTile) {
+    const int tile{std::min(kTile, size - i0)};
+    const T* tile_in{data_in + i0};
+    T* tile_out{data_out + i0};
+    for (int ii{0}; ii < tile; ++ii) {
+      tile_out[ii] = 0;
+    }
+    int kk{0};
+    for (; kk + kTaps <= window; kk += kTaps) {
+      for (int ii{0}; ii < tile; ++ii) {
+        T sum{tile_out[ii]};
+        for (int tt{0}; tt < kTaps; ++tt) {
+          sum += taps[kk + tt] * tile_in[ii + kk + tt];
+        }
+        tile_out[ii] = sum;
+      }
+    }
+    for (; kk < window; ++kk) {
+      const T tap{taps[kk]};
+      const T* shifted{tile_in + kk};
+      for (int ii{0}; ii < tile; ++ii) {
+        tile_out[ii] += tap * shifted[ii];
+      }
+    }
+  }
+}
+
+template <typename T>
+using FirConvolveFunction = void (*)(const T*, int, const T*, T*, int);
+
+template <typename T>
+FILTERING_NO_CONTRACT
+void fir_convolve_generic(const T* taps, const int window, const T* data_in,
+                          T* data_out, const int size) {
+  fir_convolve_kernel(taps, window, data_in, data_out, size);
+}
+
+#ifdef FILTERING_DISPATCH_X86
+template <typename T>
+FILTERING_TARGET("sse2") FILTERING_NO_CONTRACT
+void fir_convolve_sse2(const T* taps, const int window, const T* data_in,
+                       T* data_out, const int size) {
+  fir_convolve_kernel(taps, window, data_in, data_out, size);
+}
+
+template <typename T>
+FILTERING_TARGET("avx2,fma") FILTERING_NO_CONTRACT
+void fir_convolve_avx2(const T* taps, const int window, const T* data_in,
+                       T* data_out, const int size) {
+  fir_convolve_kernel(taps, window, data_in, data_out, size);
+}
+
+template <typename T>
+FILTERING_TARGET("avx512f,avx512vl,avx2,fma") FILTERING_NO_CONTRACT
+void fir_convolve_avx512(const T* taps, const int window, const T* data_in,
+                         T* data_out, const int size) {
+  fir_convolve_kernel(taps, window, data_in, data_out, size);
+}
+#endif
+
+/**
+ * @brief FIR convolution variant for an instruction set
+ *
+ */
+template <typename T>
+FirConvolveFunction<T> fir_convolve_for(const Isa isa) {
+#ifdef FILTERING_DISPATCH_X86
+  switch (isa) {
+    case Isa::SSE2:
+      return fir_convolve_sse2<T>;
+    case Isa::AVX2:
+      return fir_convolve_avx2<T>;
+    case Isa::AVX512:
+      return fir_convolve_avx512<T>;
+    default:
+      break;
+  }
+#endif
+  (void)isa;
+  return fir_convolve_generic<T>;
+}
+
+/**
+ * @brief FIR convolution with the variant for `active_isa()`
+ *
+ */
+template <typename T>
+void fir_convolve(const T* taps, const int window, const T* data_in,
+                  T* data_out, const int size) {
+  static const FirConvolveFunction<T> kernel{
+      fir_convolve_for<T>(active_isa())};
+  kernel(taps, window, data_in, data_out, size);
+}
+
+// EXPONENTIAL BANK KERNEL *****************************************************
+
+/**
+ * @brief Exponential filters across the channels of interleaved frames:
+ *    state[cc] = alpha[cc] * in[cc] + one_minus_alpha[cc] * state[cc]
+ *
+ */
+template <typename T, typename A>
+FILTERING_ALWAYS_INLINE FILTERING_NO_CONTRACT void exponential_bank_kernel(
+    const A* alpha, const A* one_minus_alpha, A* state, const T* data_in,
+    T* data_out, const int channels, const int frames) {
+#ifdef __clang__
+#pragma clang fp contract(off)
+#endif
+  for (int ff{0}; ff < frames; ++ff) {
+    const T* frame_in{data_in + static_cast<long>(ff) * channels};
+    T* frame_out{data_out + static_cast<long>(ff) * channels};
+    for (int cc{0}; cc < channels; ++cc) {
+      state[cc] = alpha[cc] * static_cast<A>(frame_in[cc]) +
+                  one_minus_alpha[cc] * state[cc];
+      frame_out[cc] = static_cast<T>(state[cc]);
+    }
+  }
+}
+
+template <typename T, typename A>
+using ExponentialBankFunction = void (*)(const A*, const A*, A*, const T*, T*,
+                                         int, int);
+
+template <typename T, typename A>
+FILTERING_NO_CONTRACT
+void exponential_bank_generic(const A* alpha, const A* one_minus_alpha,
+                              A* state, const T* data_in, T* data_out,
+                              const int channels, const int frames) {
+  exponential_bank_kernel(alpha, one_minus_alpha, state, data_in, data_out,
+                          channels, frames);
+}
+
+#ifdef FILTERING_DISPATCH_X86
+template <typename T, typename A>
+FILTERING_TARGET("sse2") FILTERING_NO_CONTRACT
+void exponential_bank_sse2(const A* alpha, const A* one_minus_alpha, A* state,
+                           const T* data_in, T* data_out, const int channels,
+                           const int frames) {
+  exponential_bank_kernel(alpha, one_minus_alpha, state, data_in, data_out,
+                          channels, frames);
+}
+
+template <typename T, typename A>
+FILTERING_TARGET("avx2,fma") FILTERING_NO_CONTRACT
+void exponential_bank_avx2(const A* alpha, const A* one_minus_alpha, A* state,
+                           const T* data_in, T* data_out, const int channels,
+                           const int frames) {
+  exponential_bank_kernel(alpha, one_minus_alpha, state, data_in, data_out,
+                          channels, frames);
+}
+
+template <typename T, typename A>
+FILTERING_TARGET("avx512f,avx512vl,avx2,fma") FILTERING_NO_CONTRACT
+void exponential_bank_avx512(const A* alpha, const A* one_minus_alpha,
+                             A* state, const T* data_in, T* data_out,
+                             const int channels, const int frames) {
+  exponential_bank_kernel(alpha, one_minus_alpha, state, data_in, data_out,
+                          channels, frames);
+}
+#endif
+
+/**
+ * @brief Exponential bank variant for an instruction set
+ *
+ */
+template <typename T, typename A>
+ExponentialBankFunction<T, A> exponential_bank_for(const Isa isa) {
+#ifdef FILTERING_DISPATCH_X86
+  switch (isa) {
+    case Isa::SSE2:
+      return exponential_bank_sse2<T, A>;
+    case Isa::AVX2:
+      return exponential_bank_avx2<T, A>;
+    case Isa::AVX512:
+      return exponential_bank_avx512<T, A>;
+    default:
+      break;
+  }
+#endif
+  (void)isa;
+  return exponential_bank_generic<T, A>;
+}
+
+/**
+ * @brief Exponential bank update with the variant for `active_isa()`
+ *
+ */
+template <typename T, typename A>
+void exponential_bank(const A* alpha, const A* one_minus_alpha, A* state,
+                      const T* data_in, T* data_out, const int channels,
+                      const int frames) {
+  static const ExponentialBankFunction<T, A> kernel{
+      exponential_bank_for<T, A>(active_isa())};
+  kernel(alpha, one_minus_alpha, state, data_in, data_out, channels, frames);
+}
+
+// EXPLICIT INSTANTIATIONS *****************************************************
+
+/**
+ * @brief Compiled into filtering_static/filtering_shared with tuned flags,
+ * see filter.hpp
+ *
+ */
+#ifdef FILTERING_EXTERN_TEMPLATES
+extern template void fir_convolve<float>(const float*, int, const float*,
+                                         float*, int);
+extern template void fir_convolve<double>(const double*, int, const double*,
+                                          double*, int);
+extern template void exponential_bank<float, float>(const float*, const float*,
+                                                    float*, const float*,
+                                                    float*, int, int);
+extern template void exponential_bank<double, double>(
+    const double*, const double*, double*, const double*, double*, int, int);
+#endif
+
+#endif
@@ -11,10 +11,14 @@
 #ifndef FILTER_HPP
 #define FILTER_HPP
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <vector>
 
+#include "filtering/precision.hpp"
+#include "filtering/ringbuffer.hpp"
+
 // ABSTRACT FILTER CLASS *******************************************************
 
 /**
@@ -38,11 +42,37 @@ class Filter {
    * @param data_out - reference to output of filtered data
    */
   virtual void filter(const T data_in, T& data_out) = 0;
+  /**
+   * @brief Filter a contiguous block of data points
+   *
+   * The default implementation applies `filter` to each point in turn. Filters
+   * with a cheaper block formulation override it. The input and output blocks
+   * must not overlap.
+   *
+   * @param data_in - pointer to the incoming data points
+   * @param data_out - pointer to where the filtered data is written
+   * @param size - number of data points in the block
+   */
+  virtual void filter_block(const T* data_in, T* data_out, const int size) {
+    for (int ii{0}; ii < size; ++ii) {
+      filter(data_in[ii], data_out[ii]);
+    }
+  }
   /**
    * @brief Reset the filter to an un-initialized state
    *
    */
   virtual void reset() = 0;
+  /**
+   * @brief Put the filter in the state it would settle in after a long run of
+   * a constant input, so it starts without a convergence transient
+   *
+   * The default implementation just resets the filter. Filters with a steady
+   * state override it.
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T /*value*/) { reset(); }
   /**
    * @brief Set the filter size
    *
@@ -66,11 +96,19 @@ class Filter {
  * The most basic type of filter, in which (for x in and y out):
  *    y[k] = (1-a)*y[k-1] + a*x[k]
  *
+ * y starts at zero, so a slow filter takes many samples to converge on the
+ * signal. `seed` starts it at a known operating point instead, and
+ * `seed_from_first_sample` seeds it with the first sample after each reset.
+ *
  * @tparam T - data type used by the filter
+ * @tparam P - Precision policy for the filter constant and y
  */
-template <typename T>
+template <typename T, typename P = Precision<T>>
 class ExponentialFilter : public Filter<T> {
  public:
+  using Coefficient = typename P::coefficient_type;
+  using Accumulator = typename P::accumulator_type;
+
   // CONSTRUCTORS **************************************************************
 
   /**
@@ -78,7 +116,7 @@ class ExponentialFilter : public Filter<T> {
    *
    * @param filter_constant - constant used in the filter
    */
-  ExponentialFilter(const T filter_constant)
+  ExponentialFilter(const Coefficient filter_constant)
       : _filter_constant{filter_constant} {
     if ((_filter_constant <= 0) || (_filter_constant > 1)) {
       throw std::domain_error("Filter constant must be in the range (0, 1]");
@@ -92,16 +130,64 @@ class ExponentialFilter : public Filter<T> {
    * @param data_out - reference to the output data
    */
   virtual void filter(const T data_in, T& data_out) override {
-    _filtered_data =
-        _filter_constant * data_in + (1 - _filter_constant) * _filtered_data;
-    data_out = _filtered_data;
+    if (_seed_pending) {
+      seed(data_in);
+    }
+    const Accumulator alpha{_filter_constant};
+    _filtered_data = alpha * static_cast<Accumulator>(data_in) +
+                     (1 - alpha) * _filtered_data;
+    data_out = static_cast<T>(_filtered_data);
+  }
+
+  /**
+   * @brief Filter a contiguous block of data points, keeping the state in a
+   * local so the recurrence runs without virtual calls or stores
+   *
+   * @param data_in - pointer to the incoming data points
+   * @param data_out - pointer to where the filtered data is written
+   * @param size - number of data points in the block
+   */
+  virtual void filter_block(const T* data_in, T* data_out,
+                            const int size) override {
+    if ((size > 0) && _seed_pending) {
+      seed(data_in[0]);
+    }
+    const Accumulator alpha{_filter_constant};
+    Accumulator filtered{_filtered_data};
+    for (int ii{0}; ii < size; ++ii) {
+      filtered = alpha * static_cast<Accumulator>(data_in[ii]) +
+                 (1 - alpha) * filtered;
+      data_out[ii] = static_cast<T>(filtered);
+    }
+    _filtered_data = filtered;
   }
 
   /**
    * @brief Reset the filter by setting the filtered data to ZERO
    *
    */
-  virtual void reset() override { _filtered_data = 0; }
+  virtual void reset() override {
+    _filtered_data = 0;
+    _seed_pending = _seed_from_first;
+  }
+  /**
+   * @brief Start the filter at the steady state for a constant input
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override {
+    _filtered_data = static_cast<Accumulator>(value);
+    _seed_pending = false;
+  }
+  /**
+   * @brief Seed the filter with the first sample after construction or reset
+   *
+   * @param enable - whether to seed from the first sample
+   */
+  void seed_from_first_sample(const bool enable = true) {
+    _seed_from_first = enable;
+    _seed_pending = enable;
+  }
   /**
    * @brief Set the filter size - NO EFFECT
    *
@@ -117,36 +203,58 @@ class ExponentialFilter : public Filter<T> {
    * @return std::unique_ptr<Filter<T>>
    */
   virtual std::unique_ptr<Filter<T>> clone() const override {
-    return std::make_unique<ExponentialFilter<T>>(*this);
+    return std::make_unique<ExponentialFilter<T, P>>(*this);
   }
 
  protected:
   // VARIABLES *****************************************************************
-  T _filter_constant;
-  T _filtered_data{0};
+  Coefficient _filter_constant;
+  Accumulator _filtered_data{0};
+  bool _seed_from_first{false};  ///< Seed from the first sample after reset?
+  bool _seed_pending{false};     ///< Is the next sample used as the seed?
 };
 
+/**
+ * @brief How a MovingAverageFilter behaves before its window is full
+ *
+ * Zeros: the window starts out zero-filled, so early outputs are biased
+ *        towards zero (the original behavior).
+ * Partial: the output is the average of the samples seen so far.
+ * FirstSample: the window is seeded with the first sample.
+ */
+enum class WarmUp { Zeros, Partial, FirstSample };
+
 /**
  * @brief Moving Average filter
  *
- * Note that the behavior of this filter before the data set is *full* is to
- * average with a bunch of zeros.
+ * Before the window is full, the output follows the WarmUp mode; by default
+ * the filter averages with a bunch of zeros. `primed()` reports whether the
+ * window holds only real samples. Once primed, the warm-up costs a single
+ * well-predicted comparison per sample.
+ *
+ * The window is stored as T while the running sum uses the accumulator type
+ * of the Precision policy, e.g. Precision<float, double> keeps a float window
+ * but a double sum, which stops the sum drifting over long runs.
  *
  * @tparam T - data type used by the filter
+ * @tparam P - Precision policy for the running sum
  */
-template <typename T>
+template <typename T, typename P = Precision<T>>
 class MovingAverageFilter : public Filter<T> {
  public:
+  using Accumulator = typename P::accumulator_type;
+
   // CONSTRUCTORS **************************************************************
 
   /**
    * @brief Construct a new Moving Average Filter object using the filter size
    *
    * @param filter_size - the number of data points considered by the filter
+   * @param warm_up - behavior before the window is full
    */
-  MovingAverageFilter(const int filter_size) : _filter_size{filter_size} {
-    _data.resize(_filter_size);
-  }
+  MovingAverageFilter(const int filter_size,
+                      const WarmUp warm_up = WarmUp::Zeros)
+      : _data{filter_size}, _filter_size{filter_size}, _warm_up{warm_up} {}
 
   /**
    * @brief Construct a new Moving Average Filter object using the sample
@@ -154,9 +262,12 @@ class MovingAverageFilter : public Filter<T> {
    *
    * @param call_frequency - frequency at which new data arrives [Hz]
    * @param filter_period - period at which the data is filtered [s]
+   * @param warm_up - behavior before the window is full
    */
-  MovingAverageFilter(const int call_frequency, const T filter_period)
-      : MovingAverageFilter{filter_period * call_frequency} {}
+  MovingAverageFilter(const int call_frequency, const T filter_period,
+                      const WarmUp warm_up = WarmUp::Zeros)
+      : MovingAverageFilter{static_cast<int>(filter_period * call_frequency),
+                            warm_up} {}
 
   // FILTERING FUNCTIONS *******************************************************
 
@@ -168,12 +279,54 @@ class MovingAverageFilter : public Filter<T> {
    * @param data_out - reference to output data point
    */
   virtual void filter(const T data_in, T& data_out) override {
-    int ind{circular_ind(_filter_ind++)};
+    if (_count < _filter_size) {
+      warm_up(data_in, data_out);
+      return;
+    }
+    _filter_sum = _filter_sum - static_cast<Accumulator>(_data.push(data_in)) +
+                  static_cast<Accumulator>(data_in);
 
-    _filter_sum = _filter_sum - _data[ind] + data_in;
-    _data[ind] = data_in;
+    data_out = static_cast<T>(_filter_sum / _filter_size);
+  }
+
+  /**
+   * @brief Filter a contiguous block of data points
+   *
+   * Warm-up samples go through `filter`. After that, the samples leaving the
+   * window are read from the ring buffer for the first `filter_size` points
+   * and straight from the input block afterwards, so the steady state is a
+   * branch-free loop and the ring buffer is only refilled once at the end.
+   *
+   * @param data_in - pointer to the incoming data points
+   * @param data_out - pointer to where the filtered data is written
+   * @param size - number of data points in the block
+   */
+  virtual void filter_block(const T* data_in, T* data_out,
+                            const int size) override {
+    int ii{0};
+    for (; (ii < size) && !primed(); ++ii) {
+      filter(data_in[ii], data_out[ii]);
+    }
+
+    const int start{ii};
+    const int window{_filter_size};
+    const int from_ring{std::min(size, start + window)};
+    Accumulator sum{_filter_sum};
+    for (; ii < from_ring; ++ii) {
+      sum = sum - static_cast<Accumulator>(_data[window - 1 - (ii - start)]) +
+            static_cast<Accumulator>(data_in[ii]);
+      data_out[ii] = static_cast<T>(sum / window);
+    }
+    for (; ii < size; ++ii) {
+      sum = sum - static_cast<Accumulator>(data_in[ii - window]) +
+            static_cast<Accumulator>(data_in[ii]);
+      data_out[ii] = static_cast<T>(sum / window);
+    }
+    _filter_sum = sum;
 
-    data_out = _filter_sum / _filter_size;
+    for (ii = std::max(start, size - window); ii < size; ++ii) {
+      _data.push(data_in[ii]);
+    }
   }
 
   /**
@@ -181,8 +334,20 @@ class MovingAverageFilter : public Filter<T> {
    *
    */
   virtual void reset() override {
-    std::fill(_data.begin(), _data.end(), 0);
-    _filter_ind = 0;
+    _data.reset();
+    _filter_sum = 0;
+    _count = 0;
+  }
+
+  /**
+   * @brief Fill the window with a constant input. The filter is then primed.
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override {
+    _data.fill(value);
+    _filter_sum = static_cast<Accumulator>(value) * _filter_size;
+    _count = _filter_size;
   }
 
   /**
@@ -203,28 +368,221 @@ class MovingAverageFilter : public Filter<T> {
    * @return std::unique_ptr<Filter<T>>
    */
   virtual std::unique_ptr<Filter<T>> clone() const override {
-    return std::make_unique<MovingAverageFilter<T>>(*this);
+    return std::make_unique<MovingAverageFilter<T, P>>(*this);
   }
 
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Has the window been filled with real samples since the last reset?
+   *
+   */
+  bool primed() const { return _count >= _filter_size; }
+
  private:
-  // PRIVATE SUPPORT FUNCTIONS *************************************************
+  /**
+   * @brief Filter a data point while the window is not yet full
+   *
+   */
+  void warm_up(const T data_in, T& data_out) {
+    if ((_warm_up == WarmUp::FirstSample) && (_count == 0)) {
+      _data.fill(data_in);
+      _filter_sum = static_cast<Accumulator>(data_in) * _filter_size;
+    }
+    ++_count;
+    _filter_sum = _filter_sum - static_cast<Accumulator>(_data.push(data_in)) +
+                  static_cast<Accumulator>(data_in);
+
+    const int divisor{_warm_up == WarmUp::Partial ? _count : _filter_size};
+    data_out = static_cast<T>(_filter_sum / divisor);
+  }
+
+  // VARIABLES *****************************************************************
+
+  RingBuffer<T> _data{};           ///< Internal circular data buffer
+  int _filter_size{};              ///< Size of the internal data buffer
+  WarmUp _warm_up{WarmUp::Zeros};  ///< Behavior before the window is full
+  int _count{0};                   ///< Samples seen since the last reset
+
+  Accumulator _filter_sum{0};  ///< Running sum of the entries in the buffer
+};
+
+/**
+ * @brief Moving averages over several window lengths of the same signal
+ *
+ * Running one MovingAverageFilter per window length stores every sample once
+ * per window. This filter keeps a single ring buffer sized to the largest
+ * window and one running sum per window, each dropping the sample that leaves
+ * its window, so the update is O(k) for k windows and the stored window is
+ * only as large as the longest one.
+ *
+ * `filter` with an output array gives every mean, in the order the window
+ * sizes were given; the Filter interface outputs the mean over the first
+ * window. All windows share the WarmUp mode.
+ *
+ * @tparam T - data type used by the filter
+ * @tparam P - Precision policy for the running sums
+ */
+template <typename T, typename P = Precision<T>>
+class MultiWindowAverageFilter : public Filter<T> {
+ public:
+  using Accumulator = typename P::accumulator_type;
+
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new Multi Window Average Filter object
+   *
+   * @param filter_sizes - the number of data points in each window
+   * @param warm_up - behavior before each window is full
+   */
+  MultiWindowAverageFilter(const std::vector<int>& filter_sizes,
+                           const WarmUp warm_up = WarmUp::Zeros)
+      : _filter_sizes{filter_sizes},
+        _warm_up{warm_up},
+        _filter_sums(filter_sizes.size()) {
+    if (_filter_sizes.empty()) {
+      throw std::domain_error("At least one window size is needed");
+    }
+    resize();
+  }
+
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Filter a data point, outputting the mean over every window
+   *
+   * @param data_in - input data point
+   * @param data_out - pointer to one output per window
+   */
+  void filter(const T data_in, T* data_out) {
+    update(data_in);
+    for (int kk{0}; kk < windows(); ++kk) {
+      data_out[kk] = mean(kk);
+    }
+  }
+
+  /**
+   * @brief Filter a data point, outputting the mean over the first window
+   *
+   * @param data_in - input data point
+   * @param data_out - reference to output data point
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    update(data_in);
+    data_out = mean(0);
+  }
+
+  /**
+   * @brief Reset the filter by resetting all the data points to zero.
+   *
+   */
+  virtual void reset() override {
+    _data.reset();
+    std::fill(_filter_sums.begin(), _filter_sums.end(), Accumulator{0});
+    _count = 0;
+  }
+
+  /**
+   * @brief Fill every window with a constant input. The filter is then primed.
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override {
+    _data.fill(value);
+    for (int kk{0}; kk < windows(); ++kk) {
+      _filter_sums[kk] = static_cast<Accumulator>(value) * _filter_sizes[kk];
+    }
+    _count = _data.size();
+  }
+
+  /**
+   * @brief Set the size of the first window. Note that this resets the filter
+   * automatically
+   *
+   * @param size
+   */
+  virtual void set_filter_size(const int size) override {
+    _filter_sizes[0] = size;
+    resize();
+  };
 
   /**
-   * @brief Allow an arbitrarily large index to safely index into the circular
-   * data buffer.
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
    *
-   * @param ind - regular index
-   * @return int - correct index to use when indexing into _data
+   * @return std::unique_ptr<Filter<T>>
    */
-  inline int circular_ind(const int ind) { return ind % _filter_size; }
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<MultiWindowAverageFilter<T, P>>(*this);
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Number of windows
+   *
+   */
+  int windows() const { return static_cast<int>(_filter_sizes.size()); }
+  /**
+   * @brief Mean over a window after the latest data point
+   *
+   * @param ind - index of the window, in the order given at construction
+   */
+  T mean(const int ind) const {
+    const int size{_filter_sizes[ind]};
+    const int divisor{(_warm_up == WarmUp::Partial) ? std::min(_count, size)
+                                                    : size};
+    return static_cast<T>(_filter_sums[ind] / std::max(divisor, 1));
+  }
+  /**
+   * @brief Has the largest window been filled with real samples since the
+   * last reset?
+   *
+   */
+  bool primed() const { return _count >= _data.size(); }
+
+ private:
+  /**
+   * @brief Slide every window by one data point
+   *
+   */
+  void update(const T data_in) {
+    if (!primed()) {
+      if ((_warm_up == WarmUp::FirstSample) && (_count == 0)) {
+        seed(data_in);
+        _count = 0;
+      }
+      ++_count;
+    }
+    const Accumulator x{static_cast<Accumulator>(data_in)};
+    for (int kk{0}; kk < windows(); ++kk) {
+      _filter_sums[kk] +=
+          x - static_cast<Accumulator>(_data[_filter_sizes[kk] - 1]);
+    }
+    _data.push(data_in);
+  }
+
+  /**
+   * @brief Size the ring buffer to the largest window and reset
+   *
+   */
+  void resize() {
+    if (*std::min_element(_filter_sizes.begin(), _filter_sizes.end()) < 1) {
+      throw std::domain_error("Window sizes must be positive");
+    }
+    _data.resize(
+        *std::max_element(_filter_sizes.begin(), _filter_sizes.end()));
+    reset();
+  }
 
   // VARIABLES *****************************************************************
 
-  std::vector<T> _data{};  ///< Internal data vector
-  int _filter_size{};      ///< Size of the internal data vector
+  RingBuffer<T> _data{};           ///< Ring buffer of the largest window
+  std::vector<int> _filter_sizes;  ///< Number of data points in each window
+  WarmUp _warm_up{WarmUp::Zeros};  ///< Behavior before a window is full
+  int _count{0};                   ///< Samples seen, up to the largest window
 
-  T _filter_sum{0};    ///< Running sum of the entries in the data vector
-  int _filter_ind{0};  ///< Index at which we're entering the
+  std::vector<Accumulator> _filter_sums;  ///< Running sum of each window
 };
 
 /**
@@ -234,10 +592,13 @@ class MovingAverageFilter : public Filter<T> {
  * simply define an RC constructor for it.
  *
  * @tparam T - the data type used by the filter
+ * @tparam P - Precision policy for the filter constant and output
  */
-template <typename T>
-class LowPassFilter : public ExponentialFilter<T> {
+template <typename T, typename P = Precision<T>>
+class LowPassFilter : public ExponentialFilter<T, P> {
  public:
+  using Coefficient = typename P::coefficient_type;
+
   // CONSTRUCTORS **************************************************************
 
   /**
@@ -245,14 +606,16 @@ class LowPassFilter : public ExponentialFilter<T> {
    *
    * @param filter_constant - the proportion of decay for incoming data
    */
-  LowPassFilter(T filter_constant) : ExponentialFilter<T>{filter_constant} {};
+  LowPassFilter(Coefficient filter_constant)
+      : ExponentialFilter<T, P>{filter_constant} {};
   /**
    * @brief Create a LowPassFilter visualized as an RC circuit. @overload
    *
    * @param RC - the product of the resistance and capacitance
    * @param dt - the sampling interval
    */
-  LowPassFilter(T RC, T dt) : ExponentialFilter<T>{dt / (RC + dt)} {};
+  LowPassFilter(Coefficient RC, Coefficient dt)
+      : ExponentialFilter<T, P>{dt / (RC + dt)} {};
   /**
    * @brief Create a LowPassFilter visualized as an RC circuit. @overload
    *
@@ -260,7 +623,8 @@ class LowPassFilter : public ExponentialFilter<T> {
    * @param C - the capacitance value
    * @param dt - the sampling interval
    */
-  LowPassFilter(T R, T C, T dt) : LowPassFilter{R * C, dt} {};
+  LowPassFilter(Coefficient R, Coefficient C, Coefficient dt)
+      : LowPassFilter{R * C, dt} {};
 };
 
 /**
@@ -272,16 +636,25 @@ class LowPassFilter : public ExponentialFilter<T> {
  * A high pass filter is implemented as:
  *  y[k] = alpha*y[k-1] + alpha*(x[k] - x[k-1])
  *
+ * x[-1] is zero unless the filter is seeded, so without a seed a signal with
+ * a large offset produces a large spike on the first sample.
+ *
  * @tparam T - the data type used by the filter
+ * @tparam P - Precision policy for the filter constant and output
  */
-template <typename T>
-class HighPassFilter : public ExponentialFilter<T> {
-  using ExponentialFilter<T>::_filter_constant;  ///< Gives access to protected
-                                                 ///< member
-  using ExponentialFilter<T>::_filtered_data;    ///< Gives access to protected
-                                                 ///< member
+template <typename T, typename P = Precision<T>>
+class HighPassFilter : public ExponentialFilter<T, P> {
+  using ExponentialFilter<T, P>::_filter_constant;  ///< Gives access to
+                                                    ///< protected member
+  using ExponentialFilter<T, P>::_filtered_data;    ///< Gives access to
+                                                    ///< protected member
+  using ExponentialFilter<T, P>::_seed_pending;     ///< Gives access to
+                                                    ///< protected member
 
  public:
+  using Coefficient = typename P::coefficient_type;
+  using Accumulator = typename P::accumulator_type;
+
   // CONSTRUCTORS **************************************************************
 
   /**
@@ -289,14 +662,16 @@ class HighPassFilter : public ExponentialFilter<T> {
    *
    * @param filter_constant - the proportion of decay for the data
    */
-  HighPassFilter(T filter_constant) : ExponentialFilter<T>{filter_constant} {};
+  HighPassFilter(Coefficient filter_constant)
+      : ExponentialFilter<T, P>{filter_constant} {};
   /**
    * @brief Create a HighPassFilter visualized as an RC circuit. @overload
    *
    * @param RC - the product of the resistance and capacticance
    * @param dt - the sampling interval
    */
-  HighPassFilter(T RC, T dt) : ExponentialFilter<T>{RC / (RC + dt)} {};
+  HighPassFilter(Coefficient RC, Coefficient dt)
+      : ExponentialFilter<T, P>{RC / (RC + dt)} {};
   /**
    * @brief Create a HighPassFilter visualized as an RC circuit. @overload
    *
@@ -304,8 +679,162 @@ class HighPassFilter : public ExponentialFilter<T> {
    * @param C - the capacitance value
    * @param dt - the sampling interval
    */
-  HighPassFilter(T R, T C, T dt) : HighPassFilter(R * C, dt){};
+  HighPassFilter(Coefficient R, Coefficient C, Coefficient dt)
+      : HighPassFilter(R * C, dt){};
+
+  /**
+   * @brief Filter the data coming in
+   *
+   * @param data_in - the newest data point input to the filter
+   * @param data_out - reference to where to put the output filtered data.
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    if (_seed_pending) {
+      seed(data_in);
+    }
+    const Accumulator alpha{_filter_constant};
+    _filtered_data =
+        alpha * _filtered_data + alpha * (static_cast<Accumulator>(data_in) -
+                                          static_cast<Accumulator>(_last_data));
+    _last_data = data_in;
+    data_out = static_cast<T>(_filtered_data);
+  }
+
+  /**
+   * @brief Filter a contiguous block of data points
+   *
+   * @param data_in - pointer to the incoming data points
+   * @param data_out - pointer to where the filtered data is written
+   * @param size - number of data points in the block
+   */
+  virtual void filter_block(const T* data_in, T* data_out,
+                            const int size) override {
+    if ((size > 0) && _seed_pending) {
+      seed(data_in[0]);
+    }
+    const Accumulator alpha{_filter_constant};
+    Accumulator filtered{_filtered_data};
+    T last{_last_data};
+    for (int ii{0}; ii < size; ++ii) {
+      filtered = alpha * filtered +
+                 alpha * (static_cast<Accumulator>(data_in[ii]) -
+                          static_cast<Accumulator>(last));
+      last = data_in[ii];
+      data_out[ii] = static_cast<T>(filtered);
+    }
+    _filtered_data = filtered;
+    _last_data = last;
+  }
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<HighPassFilter<T, P>>(*this);
+  }
+
+  /**
+   * @brief Reset the filter by setting the filtered and previous data to ZERO
+   *
+   */
+  virtual void reset() override {
+    ExponentialFilter<T, P>::reset();
+    _last_data = 0;
+  }
+  /**
+   * @brief Start the filter at the steady state for a constant input, i.e.
+   * a zero output with `value` as the previous data point
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override {
+    ExponentialFilter<T, P>::seed(value);
+    _filtered_data = 0;
+    _last_data = value;
+  }
+
+ private:
+  T _last_data{0};  ///< Previous input data point
+};
+
+// STATIC FILTERS **************************************************************
+
+/**
+ * @brief Exponential Filter whose constant is fixed at compile time
+ *
+ * The constant is a reference to a constexpr value, e.g.
+ *    static constexpr double kAlpha = low_pass_constant(5.0, 100.0);
+ *    StaticExponentialFilter<double, kAlpha> lp;
+ * (see design.hpp), so it is folded into the filter step and an invalid
+ * constant fails to compile instead of throwing std::domain_error.
+ *
+ * @tparam T - data type used by the filter
+ * @tparam FilterConstant - reference to a constexpr constant in (0, 1]
+ */
+template <typename T, const T& FilterConstant>
+class StaticExponentialFilter : public Filter<T> {
+  static_assert((FilterConstant > 0) && (FilterConstant <= 1),
+                "Filter constant must be in the range (0, 1]");
+
+ public:
+  /**
+   * @brief Apply the filter to a new input data point
+   *
+   * @param data_in - newest arrived data point
+   * @param data_out - reference to the output data
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    _filtered_data =
+        FilterConstant * data_in + (1 - FilterConstant) * _filtered_data;
+    data_out = _filtered_data;
+  }
+
+  /**
+   * @brief Reset the filter by setting the filtered data to ZERO
+   *
+   */
+  virtual void reset() override { _filtered_data = 0; }
+  /**
+   * @brief Start the filter at the steady state for a constant input
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override { _filtered_data = value; }
+  /**
+   * @brief Set the filter size - NO EFFECT
+   *
+   * @param size - the size of the filter
+   */
+  virtual void set_filter_size(const int size) override { return; };
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<StaticExponentialFilter<T, FilterConstant>>(*this);
+  }
+
+ private:
+  T _filtered_data{0};
+};
+
+/**
+ * @brief High Pass Filter whose constant is fixed at compile time
+ *
+ * @see StaticExponentialFilter, HighPassFilter
+ *
+ * @tparam T - data type used by the filter
+ * @tparam FilterConstant - reference to a constexpr constant in (0, 1]
+ */
+template <typename T, const T& FilterConstant>
+class StaticHighPassFilter : public Filter<T> {
+  static_assert((FilterConstant > 0) && (FilterConstant <= 1),
+                "Filter constant must be in the range (0, 1]");
 
+ public:
   /**
    * @brief Filter the data coming in
    *
@@ -313,14 +842,67 @@ class HighPassFilter : public ExponentialFilter<T> {
    * @param data_out - reference to where to put the output filtered data.
    */
   virtual void filter(const T data_in, T& data_out) override {
-    _filtered_data = _filter_constant * _filtered_data +
-                     _filter_constant * (data_in - _last_data);
+    _filtered_data = FilterConstant * _filtered_data +
+                     FilterConstant * (data_in - _last_data);
     _last_data = data_in;
     data_out = _filtered_data;
   }
 
+  /**
+   * @brief Reset the filter by setting the filtered data to ZERO
+   *
+   */
+  virtual void reset() override {
+    _filtered_data = 0;
+    _last_data = 0;
+  }
+  /**
+   * @brief Start the filter at the steady state for a constant input
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override {
+    _filtered_data = 0;
+    _last_data = value;
+  }
+  /**
+   * @brief Set the filter size - NO EFFECT
+   *
+   * @param size - the size of the filter
+   */
+  virtual void set_filter_size(const int size) override { return; };
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<StaticHighPassFilter<T, FilterConstant>>(*this);
+  }
+
  private:
-  T _last_data;
+  T _filtered_data{0};
+  T _last_data{0};
 };
 
+// EXPLICIT INSTANTIATIONS *****************************************************
+
+/**
+ * @brief With the compiled filtering_static/filtering_shared targets, the
+ * common instantiations are compiled once into the library instead of into
+ * every translation unit.
+ */
+#ifdef FILTERING_EXTERN_TEMPLATES
+extern template class ExponentialFilter<float>;
+extern template class ExponentialFilter<double>;
+extern template class MovingAverageFilter<float>;
+extern template class MovingAverageFilter<double>;
+extern template class MultiWindowAverageFilter<float>;
+extern template class MultiWindowAverageFilter<double>;
+extern template class LowPassFilter<float>;
+extern template class LowPassFilter<double>;
+extern template class HighPassFilter<float>;
+extern template class HighPassFilter<double>;
+#endif
+
 #endif
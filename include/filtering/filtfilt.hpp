@@ -0,0 +1,240 @@
+/**
+ * @file filtfilt.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Zero-phase forward-backward filtering of recorded data
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef FILTFILT_FILTER_HPP
+#define FILTFILT_FILTER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "filtering/analysis.hpp"
+#include "filtering/filter.hpp"
+#include "filtering/multistream.hpp"
+
+/**
+ * @brief Options for forward-backward filtering
+ *
+ */
+struct FiltFiltOptions {
+  long chunk_frames{1 << 16};  ///< Output frames produced per backward pass
+  long overlap{-1};  ///< Look-ahead of each backward pass (-1: settling length)
+  long padding{-1};  ///< Reflected samples at each end (-1: settling length)
+};
+
+/**
+ * @brief Number of samples after which a filter's impulse response has
+ * decayed below `tolerance` times its peak
+ *
+ * @param filter - any filter
+ * @param tolerance - relative size of the ignored tail
+ * @param max_length - longest impulse response considered
+ */
+template <typename T>
+long settling_length(const Filter<T>& filter, const double tolerance = 1e-9,
+                     const int max_length = 1 << 16) {
+  return static_cast<long>(
+      truncated_impulse_response(filter, max_length, tolerance).size());
+}
+
+// FORWARD-BACKWARD FILTERING **************************************************
+
+/**
+ * @brief Zero-phase filter one signal: filter it forward, then filter the
+ * result backward in time
+ *
+ * The signal is extended at both ends by odd reflection about its end points,
+ * and each pass is seeded with its first value, so there are no start-up
+ * transients at the edges. The result has zero phase and the squared gain of
+ * the filter.
+ *
+ * The signal is streamed in chunks, so working memory is O(chunk + overlap)
+ * whatever the signal length, and the input can be a memory-mapped file. The
+ * forward pass runs through the whole signal once. Each chunk's backward pass
+ * starts `overlap` samples after the chunk, seeded with the forward output
+ * there; once the filter has settled over the overlap, the result matches
+ * filtering the whole signal at once (and is identical when the chunk reaches
+ * the end of the signal).
+ *
+ * @param filter - any filter, cloned for the two passes
+ * @param data_in - first input sample
+ * @param data_out - first output sample, must not overlap the input
+ * @param size - number of samples
+ * @param stride - distance between consecutive samples, e.g. the number of
+ * channels of interleaved data
+ * @param options - chunk size, overlap and padding
+ * @throws std::domain_error if a chunk with its overlap and padding does not
+ * fit in the int count of `filter_block`
+ */
+template <typename T>
+void filtfilt(const Filter<T>& filter, const T* data_in, T* data_out,
+              const long size, const long stride = 1,
+              const FiltFiltOptions& options = {}) {
+  if (size < 1) {
+    return;
+  }
+  if (options.chunk_frames < 1) {
+    throw std::domain_error("Chunk size must be positive");
+  }
+  const long settling{((options.overlap < 0) || (options.padding < 0))
+                          ? settling_length(filter)
+                          : 0};
+  const long overlap{options.overlap < 0 ? settling : options.overlap};
+  const long padding{
+      std::min(options.padding < 0 ? settling : options.padding, size - 1)};
+  // Longest block handed to filter_block, the first forward pass
+  const long longest{std::min(options.chunk_frames, size) +
+                     std::min(overlap, size) + padding};
+  if (longest > std::numeric_limits<int>::max()) {
+    throw std::domain_error(
+        "Chunk size, overlap and padding must fit in an int");
+  }
+
+  const auto input = [&](const long ii) { return data_in[ii * stride]; };
+  const auto extended = [&](const long ii) {
+    if (ii < 0) {
+      return static_cast<T>(2 * input(0) - input(-ii));
+    }
+    if (ii >= size) {
+      return static_cast<T>(2 * input(size - 1) - input(2 * (size - 1) - ii));
+    }
+    return input(ii);
+  };
+
+  const std::unique_ptr<Filter<T>> forward{filter.clone()};
+  const std::unique_ptr<Filter<T>> backward{filter.clone()};
+  std::vector<T> block_in;
+  std::vector<T> block_out;
+  std::vector<T> filtered;  // forward output from sample `first` on
+  long first{-padding};
+  long done{-padding};  // next sample for the forward pass
+
+  const auto run_forward = [&](const long end) {
+    const long count{end - done};
+    block_in.resize(count);
+    for (long ii{0}; ii < count; ++ii) {
+      block_in[ii] = extended(done + ii);
+    }
+    const std::size_t old_size{filtered.size()};
+    filtered.resize(old_size + count);
+    forward->filter_block(block_in.data(), filtered.data() + old_size,
+                          static_cast<int>(count));
+    done = end;
+  };
+
+  forward->seed(extended(-padding));
+  for (long start{0}; start < size; start += options.chunk_frames) {
+    const long stop{std::min(start + options.chunk_frames, size)};
+    const long end{std::min(stop + overlap, size + padding)};
+    if (end > done) {
+      run_forward(end);
+    }
+
+    // Backward over [start, end), newest sample first
+    const long count{end - start};
+    block_in.resize(count);
+    block_out.resize(count);
+    for (long ii{0}; ii < count; ++ii) {
+      block_in[ii] = filtered[end - 1 - ii - first];
+    }
+    backward->seed(block_in[0]);
+    backward->filter_block(block_in.data(), block_out.data(),
+                           static_cast<int>(count));
+    for (long ii{start}; ii < stop; ++ii) {
+      data_out[ii * stride] = block_out[end - 1 - ii];
+    }
+
+    filtered.erase(filtered.begin(), filtered.begin() + (stop - first));
+    first = stop;
+  }
+}
+
+/**
+ * @brief Zero-phase filter every channel of a time-by-channel block, with the
+ * channels spread over worker threads
+ *
+ * If a channel fails, the remaining channels are still processed and the
+ * first error is rethrown once all workers have finished.
+ *
+ * @param filter - any filter, cloned for every channel
+ * @param data_in - pointer to channels * frames incoming data points
+ * @param data_out - pointer to where the filtered data is written, must not
+ * overlap the input
+ * @param channels - number of channels
+ * @param frames - number of samples per channel
+ * @param layout - Interleaved (row-major) or Planar (column-major)
+ * @param threads - number of worker threads (0 for one per hardware thread)
+ * @param options - chunk size, overlap and padding
+ */
+template <typename T>
+void filtfilt_frames(const Filter<T>& filter, const T* data_in, T* data_out,
+                     const int channels, const long frames,
+                     const SampleLayout layout, int threads = 0,
+                     const FiltFiltOptions& options = {}) {
+  if (threads <= 0) {
+    threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  threads = std::max(1, std::min(threads, channels));
+
+  FiltFiltOptions resolved{options};
+  if ((resolved.overlap < 0) || (resolved.padding < 0)) {
+    const long settling{settling_length(filter)};
+    resolved.overlap = resolved.overlap < 0 ? settling : resolved.overlap;
+    resolved.padding = resolved.padding < 0 ? settling : resolved.padding;
+  }
+
+  const bool planar{layout == SampleLayout::Planar};
+  const long stride{planar ? 1 : channels};
+  std::atomic<int> next{0};
+  std::exception_ptr error{nullptr};
+  std::atomic_flag error_set = ATOMIC_FLAG_INIT;
+
+  const auto worker = [&]() {
+    for (int cc{next++}; cc < channels; cc = next++) {
+      const long offset{planar ? cc * frames : cc};
+      try {
+        filtfilt(filter, data_in + offset, data_out + offset, frames, stride,
+                 resolved);
+      } catch (...) {
+        if (!error_set.test_and_set()) {
+          error = std::current_exception();
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  const auto join = [&workers]() {
+    for (auto& thread : workers) {
+      thread.join();
+    }
+  };
+  try {
+    for (int ii{0}; ii < threads - 1; ++ii) {
+      workers.emplace_back(worker);
+    }
+  } catch (...) {
+    next = channels;  // the started workers stop after their channel
+    join();
+    throw;
+  }
+  worker();
+  join();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+#endif
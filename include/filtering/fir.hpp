@@ -0,0 +1,268 @@
+/**
+ * @file fir.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Finite impulse response (FIR) filters
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef FIR_FILTER_HPP
+#define FIR_FILTER_HPP
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "filtering/dispatch.hpp"
+#include "filtering/filter.hpp"
+#include "filtering/ringbuffer.hpp"
+
+// FIR FILTER ******************************************************************
+
+/**
+ * @brief FIR filter with taps chosen at runtime
+ *
+ * Implements (for x in and y out, with M taps stored oldest point first):
+ *    y[k] = taps[0]*x[k-M+1] + ... + taps[M-1]*x[k]
+ * Like the MovingAverageFilter, the window is zero-filled until it is full.
+ *
+ * @tparam T - data type used by the filter
+ */
+template <typename T>
+class FIRFilter : public Filter<T> {
+ public:
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new FIR Filter object from its taps
+   *
+   * @param taps - filter taps, oldest point first
+   */
+  FIRFilter(const std::vector<T>& taps) { set_taps(taps); }
+
+  /**
+   * @brief Construct a new FIR Filter object from a (constexpr) design.
+   * @overload
+   *
+   * @param taps - filter taps, oldest point first
+   */
+  template <std::size_t M>
+  FIRFilter(const std::array<T, M>& taps)
+      : FIRFilter{std::vector<T>(taps.begin(), taps.end())} {}
+
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Apply the filter to a new input data point
+   *
+   * @param data_in - newest arrived data point
+   * @param data_out - reference to the output data
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    _data.push(data_in);
+
+    // Oldest points live in [head, size), newest in [0, head)
+    const T* data{_data.data()};
+    const int head{_data.head()};
+    const int split{_data.size() - head};
+
+    T sum{0};
+    for (int ii{0}; ii < split; ++ii) {
+      sum += _taps[ii] * data[head + ii];
+    }
+    for (int ii{split}; ii < _data.size(); ++ii) {
+      sum += _taps[ii] * data[ii - split];
+    }
+    data_out = sum;
+  }
+
+  /**
+   * @brief Filter a block of data points
+   *
+   * Once the window has been filled from the block itself, the convolution
+   * reads straight from the input array, using the kernel for the CPU's
+   * instruction set (see dispatch.hpp).
+   *
+   * @param data_in - pointer to the incoming data points
+   * @param data_out - pointer to where the filtered data is written
+   * @param size - number of data points in the block
+   */
+  virtual void filter_block(const T* data_in, T* data_out,
+                            const int size) override {
+    const int window{_data.size()};
+    const int lead{std::min(size, window - 1)};
+
+    for (int ii{0}; ii < lead; ++ii) {
+      filter(data_in[ii], data_out[ii]);
+    }
+    if (size > lead) {
+      fir_convolve(_taps.data(), window, data_in + lead - (window - 1),
+                   data_out + lead, size - lead);
+    }
+    for (int ii{std::max(lead, size - window)}; ii < size; ++ii) {
+      _data.push(data_in[ii]);
+    }
+  }
+
+  /**
+   * @brief Reset the filter by resetting all the data points to zero.
+   *
+   */
+  virtual void reset() override { _data.reset(); }
+  /**
+   * @brief Fill the window with a constant input
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override { _data.fill(value); }
+  /**
+   * @brief Set the filter size - NO EFFECT
+   *
+   * The window of a FIR filter is fixed by its taps.
+   *
+   * @param size - the size of the filter
+   */
+  virtual void set_filter_size(const int size) override { return; };
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<FIRFilter<T>>(*this);
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Filter taps, oldest point first
+   *
+   */
+  const std::vector<T>& taps() const { return _taps; }
+
+ protected:
+  // PROTECTED SUPPORT FUNCTIONS ***********************************************
+
+  /**
+   * @brief Replace the taps. Note that this resets the filter.
+   *
+   * @param taps - filter taps, oldest point first
+   */
+  void set_taps(std::vector<T> taps) {
+    if (taps.empty()) {
+      throw std::domain_error("FIR filter needs at least one tap");
+    }
+    _data.resize(static_cast<int>(taps.size()));
+    _taps = std::move(taps);
+  }
+
+ private:
+  // VARIABLES *****************************************************************
+
+  RingBuffer<T> _data{};   ///< Internal circular data buffer
+  std::vector<T> _taps{};  ///< Filter taps, oldest point first
+};
+
+// STATIC FIR FILTER ***********************************************************
+
+/**
+ * @brief FIR filter whose taps are fixed at compile time
+ *
+ * The taps are a reference to a constexpr std::array, e.g.
+ *    static constexpr auto kTaps = fir_low_pass<double, 31>(10.0, 1000.0);
+ *    StaticFIRFilter<double, kTaps> fir;
+ * so the compiler can fold them into the loop and they can live in read-only
+ * memory. The window is a fixed-size array, so the filter never allocates.
+ *
+ * @tparam T - data type used by the filter
+ * @tparam Taps - reference to a constexpr std::array<T, M> of taps
+ */
+template <typename T, const auto& Taps>
+class StaticFIRFilter : public Filter<T> {
+  static constexpr int kSize{static_cast<int>(
+      std::tuple_size<std::decay_t<decltype(Taps)>>::value)};
+  static_assert(kSize >= 1, "FIR filter needs at least one tap");
+
+ public:
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Apply the filter to a new input data point
+   *
+   * @param data_in - newest arrived data point
+   * @param data_out - reference to the output data
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    _data[_head] = data_in;
+    if (++_head == kSize) {
+      _head = 0;
+    }
+
+    const int split{kSize - _head};
+    T sum{0};
+    for (int ii{0}; ii < split; ++ii) {
+      sum += Taps[ii] * _data[_head + ii];
+    }
+    for (int ii{split}; ii < kSize; ++ii) {
+      sum += Taps[ii] * _data[ii - split];
+    }
+    data_out = sum;
+  }
+
+  /**
+   * @brief Reset the filter by resetting all the data points to zero.
+   *
+   */
+  virtual void reset() override {
+    _data.fill(0);
+    _head = 0;
+  }
+  /**
+   * @brief Fill the window with a constant input
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override { _data.fill(value); }
+  /**
+   * @brief Set the filter size - NO EFFECT
+   *
+   * The window of a FIR filter is fixed by its taps.
+   *
+   * @param size - the size of the filter
+   */
+  virtual void set_filter_size(const int size) override { return; };
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<StaticFIRFilter<T, Taps>>(*this);
+  }
+
+ private:
+  // VARIABLES *****************************************************************
+
+  std::array<T, kSize> _data{};  ///< Internal circular data buffer
+  int _head{0};                  ///< Index at which the next point is entered
+};
+
+// EXPLICIT INSTANTIATIONS *****************************************************
+
+/**
+ * @brief Compiled into filtering_static/filtering_shared, see filter.hpp
+ *
+ */
+#ifdef FILTERING_EXTERN_TEMPLATES
+extern template class FIRFilter<float>;
+extern template class FIRFilter<double>;
+#endif
+
+#endif
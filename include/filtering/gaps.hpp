@@ -0,0 +1,286 @@
+/**
+ * @file gaps.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Handling of missing (NaN) samples without poisoning filter state
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef GAP_FILTER_HPP
+#define GAP_FILTER_HPP
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "filtering/filter.hpp"
+
+/**
+ * @brief What to do with a missing (NaN) sample
+ *
+ * Skip: the wrapped filter is not updated and the last output is repeated.
+ * Hold: the last valid sample is fed to the wrapped filter instead.
+ * Interpolate: in filter_block, gaps followed by a valid sample in the same
+ *              block are filled by linear interpolation from the last valid
+ *              sample. Other gaps (and all gaps in `filter`, which cannot see
+ *              ahead) are held.
+ * MarkInvalid: the state is updated as for Hold, but the output is NaN so that
+ *              downstream consumers see the gap.
+ */
+enum class GapPolicy { Skip, Hold, Interpolate, MarkInvalid };
+
+/**
+ * @brief Is a sample missing? Types without NaN never have gaps.
+ *
+ */
+template <typename T>
+inline bool is_gap(const T data) {
+  if constexpr (std::numeric_limits<T>::has_quiet_NaN) {
+    return std::isnan(data);
+  } else {
+    return false;
+  }
+}
+
+/**
+ * @brief Does a block contain any missing sample? A single vectorizable scan.
+ *
+ */
+template <typename T>
+inline bool has_gaps(const T* data, const long size) {
+  bool any_gap{false};
+  for (long ii{0}; ii < size; ++ii) {
+    any_gap |= is_gap(data[ii]);
+  }
+  return any_gap;
+}
+
+/**
+ * @brief Wrap any filter so that NaN samples never reach its state
+ *
+ * A single NaN fed to an ExponentialFilter or MovingAverageFilter poisons its
+ * state until `reset()`. The GapFilter replaces or drops NaN samples according
+ * to a GapPolicy before they reach the wrapped filter. Before the first valid
+ * sample, the "last valid sample" is zero, matching the filters' initial state.
+ *
+ * In `filter_block`, a block without NaNs costs one vectorizable scan before
+ * being handed unchanged to the wrapped filter's `filter_block`. Hold and
+ * MarkInvalid repair blocks with gaps in branch-free select loops; Interpolate
+ * and Skip branch on the runs of gaps and valid samples.
+ *
+ * Wrap the filters of a MultiStreamFilter in GapFilters to handle gaps per
+ * stream; ExponentialFilterBank and EWStatisticsBank take a GapPolicy through
+ * `set_gap_policy`.
+ *
+ * @tparam T - data type used by the filter
+ */
+template <typename T>
+class GapFilter : public Filter<T> {
+ public:
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new Gap Filter object around any type of Filter
+   *
+   * @param filter - an anonymous object of any Filter sub-type.
+   * @param policy - handling of NaN samples
+   */
+  GapFilter(Filter<T> const& filter, const GapPolicy policy)
+      : _filter{filter.clone()}, _policy{policy} {}
+
+  /**
+   * @brief Copy a Gap Filter object, cloning the wrapped filter
+   *
+   * @param other - filter to copy
+   */
+  GapFilter(const GapFilter<T>& other)
+      : _filter{other._filter->clone()},
+        _policy{other._policy},
+        _last_valid{other._last_valid},
+        _last_output{other._last_output} {}
+
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Apply the wrapped filter to a new input data point
+   *
+   * @param data_in - newest arrived data point, possibly NaN
+   * @param data_out - reference to the output data
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    const bool valid{!is_gap(data_in)};
+
+    if (_policy == GapPolicy::Skip) {
+      if (valid) {
+        _filter->filter(data_in, _last_output);
+      }
+      data_out = _last_output;
+      return;
+    }
+
+    _last_valid = valid ? data_in : _last_valid;
+    _filter->filter(_last_valid, _last_output);
+    data_out = (_policy == GapPolicy::MarkInvalid) && !valid ? kGap
+                                                             : _last_output;
+  }
+
+  /**
+   * @brief Filter a block of data points, possibly containing NaNs
+   *
+   * @param data_in - pointer to the incoming data points
+   * @param data_out - pointer to where the filtered data is written
+   * @param size - number of data points in the block
+   */
+  virtual void filter_block(const T* data_in, T* data_out,
+                            const int size) override {
+    if (size <= 0) {
+      return;
+    }
+
+    if (!has_gaps(data_in, size)) {
+      _filter->filter_block(data_in, data_out, size);
+      _last_valid = data_in[size - 1];
+      _last_output = data_out[size - 1];
+      return;
+    }
+
+    switch (_policy) {
+      case GapPolicy::Skip:
+        filter_valid_runs(data_in, data_out, size);
+        return;
+      case GapPolicy::Interpolate:
+        interpolate(data_in, size);
+        break;
+      default:
+        hold(data_in, size);
+        break;
+    }
+    _filter->filter_block(_scratch.data(), data_out, size);
+    _last_output = data_out[size - 1];
+
+    if (_policy == GapPolicy::MarkInvalid) {
+      for (int ii{0}; ii < size; ++ii) {
+        data_out[ii] = is_gap(data_in[ii]) ? kGap : data_out[ii];
+      }
+    }
+  }
+
+  /**
+   * @brief Reset the wrapped filter and forget the last valid sample
+   *
+   */
+  virtual void reset() override {
+    _filter->reset();
+    _last_valid = 0;
+    _last_output = 0;
+  }
+
+  /**
+   * @brief Seed the wrapped filter. The value also becomes the last valid
+   * sample and the output repeated over skipped gaps until the next sample.
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override {
+    _filter->seed(value);
+    _last_valid = value;
+    _last_output = value;
+  }
+
+  /**
+   * @brief Set the filter size of the wrapped filter
+   *
+   * @param size - how many data points does the filter consider?
+   */
+  virtual void set_filter_size(const int size) override {
+    _filter->set_filter_size(size);
+  }
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<GapFilter<T>>(*this);
+  }
+
+ private:
+  // PRIVATE SUPPORT FUNCTIONS *************************************************
+
+  /**
+   * @brief Fill the scratch block, replacing gaps by the last valid sample
+   *
+   */
+  void hold(const T* data_in, const int size) {
+    _scratch.resize(size);
+    T last{_last_valid};
+    for (int ii{0}; ii < size; ++ii) {
+      last = is_gap(data_in[ii]) ? last : data_in[ii];
+      _scratch[ii] = last;
+    }
+    _last_valid = last;
+  }
+
+  /**
+   * @brief Fill the scratch block, interpolating gaps that end in the block
+   *
+   */
+  void interpolate(const T* data_in, const int size) {
+    const T before_block{_last_valid};
+    hold(data_in, size);
+
+    int gap_start{-1};
+    for (int ii{0}; ii < size; ++ii) {
+      if (is_gap(data_in[ii])) {
+        gap_start = gap_start < 0 ? ii : gap_start;
+      } else if (gap_start >= 0) {
+        const T before{gap_start > 0 ? _scratch[gap_start - 1] : before_block};
+        const T step{(data_in[ii] - before) / (ii - gap_start + 1)};
+        for (int jj{gap_start}; jj < ii; ++jj) {
+          _scratch[jj] = before + step * (jj - gap_start + 1);
+        }
+        gap_start = -1;
+      }
+    }
+  }
+
+  /**
+   * @brief Feed only the runs of valid samples to the wrapped filter
+   *
+   */
+  void filter_valid_runs(const T* data_in, T* data_out, const int size) {
+    int ii{0};
+    while (ii < size) {
+      int end{ii};
+      if (is_gap(data_in[ii])) {
+        while ((end < size) && is_gap(data_in[end])) {
+          data_out[end++] = _last_output;
+        }
+      } else {
+        while ((end < size) && !is_gap(data_in[end])) {
+          ++end;
+        }
+        _filter->filter_block(data_in + ii, data_out + ii, end - ii);
+        _last_valid = data_in[end - 1];
+        _last_output = data_out[end - 1];
+      }
+      ii = end;
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  static constexpr T kGap{std::numeric_limits<T>::quiet_NaN()};
+
+  std::unique_ptr<Filter<T>> _filter;  ///< Wrapped filter
+  GapPolicy _policy;                   ///< Handling of NaN samples
+  T _last_valid{0};                    ///< Last valid sample
+  T _last_output{0};                   ///< Last output of the wrapped filter
+  std::vector<T> _scratch{};           ///< Repaired copy of a block
+};
+
+#endif
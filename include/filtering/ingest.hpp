@@ -0,0 +1,443 @@
+/**
+ * @file ingest.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Sharded multi-producer ingestion of samples into a filter bank
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef INGEST_FILTER_HPP
+#define INGEST_FILTER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "filtering/aligned.hpp"
+#include "filtering/filter.hpp"
+
+// MPSC QUEUE ******************************************************************
+
+/**
+ * @brief Bounded lock-free multi-producer single-consumer queue
+ *
+ * Each cell carries a sequence number telling producers and the consumer
+ * whose turn it is (D. Vyukov's bounded queue), so producers only contend on
+ * one atomic increment and the consumer never takes a lock. Items pushed by
+ * one producer are popped in the order they were pushed.
+ *
+ * @tparam T - item type
+ */
+template <typename T>
+class MpscQueue {
+ public:
+  // CONSTRUCTOR ***************************************************************
+
+  /**
+   * @brief Construct a new MPSC Queue object
+   *
+   * @param capacity - maximum number of queued items, rounded up to a power
+   * of two
+   */
+  MpscQueue(const std::size_t capacity) {
+    std::size_t size{1};
+    while (size < std::max<std::size_t>(capacity, 2)) {
+      size <<= 1;
+    }
+    _mask = size - 1;
+    _cells = std::make_unique<Cell[]>(size);
+    for (std::size_t ii{0}; ii < size; ++ii) {
+      _cells[ii].sequence.store(ii, std::memory_order_relaxed);
+    }
+  }
+
+  // QUEUE FUNCTIONS ***********************************************************
+
+  /**
+   * @brief Push an item if there is room. Safe from any number of threads.
+   *
+   * @param item - item to queue
+   * @return true - the item was queued
+   * @return false - the queue was full
+   */
+  bool try_push(const T& item) {
+    std::size_t pos{_tail.load(std::memory_order_relaxed)};
+    for (;;) {
+      Cell& cell{_cells[pos & _mask]};
+      const std::size_t sequence{cell.sequence.load(std::memory_order_acquire)};
+      const auto diff{static_cast<std::ptrdiff_t>(sequence - pos)};
+      if (diff == 0) {
+        if (_tail.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          cell.item = item;
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = _tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Pop the oldest item if there is one. Only one thread may pop.
+   *
+   * @param item - set to the popped item
+   * @return true - an item was popped
+   * @return false - the queue was empty
+   */
+  bool try_pop(T& item) {
+    Cell& cell{_cells[_head & _mask]};
+    const std::size_t sequence{cell.sequence.load(std::memory_order_acquire)};
+    if (sequence != _head + 1) {
+      return false;
+    }
+    item = cell.item;
+    cell.sequence.store(_head + _mask + 1, std::memory_order_release);
+    ++_head;
+    return true;
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Number of items ever claimed by producers
+   *
+   */
+  std::size_t pushed() const { return _tail.load(std::memory_order_acquire); }
+  /**
+   * @brief Approximate number of queued items, from the consumer's side
+   *
+   */
+  std::size_t depth() const { return pushed() - _head; }
+
+ private:
+  /**
+   * @brief One slot of the queue
+   *
+   */
+  struct Cell {
+    std::atomic<std::size_t> sequence{0};  ///< Whose turn the cell is
+    T item{};                              ///< Queued item
+  };
+
+  std::unique_ptr<Cell[]> _cells{};  ///< Ring of cells
+  std::size_t _mask{0};              ///< Number of cells minus one
+  alignas(kCacheLineSize) std::atomic<std::size_t> _tail{0};  ///< Next push
+  alignas(kCacheLineSize) std::size_t _head{0};  ///< Next pop (consumer only)
+};
+
+// SHARDED FILTER BANK *********************************************************
+
+/**
+ * @brief Load statistics of one shard of a ShardedFilterBank
+ *
+ */
+struct ShardStats {
+  std::uint64_t samples{0};     ///< Samples filtered by the shard
+  std::uint64_t full_waits{0};  ///< Times a producer found the queue full
+  std::uint64_t max_depth{0};   ///< Deepest queue seen by the shard thread
+  std::uint64_t busy_ns{0};     ///< Time spent filtering [ns]
+  int channels{0};              ///< Channels owned by the shard
+};
+
+/**
+ * @brief Filter bank fed concurrently by many producer threads
+ *
+ * Channels are hashed to shards, each owned by one worker thread that holds
+ * the filters of its channels. Producers push (channel, value) samples into
+ * the owning shard's lock-free MPSC queue and never touch a filter, so there
+ * is no lock around the bank and shards scale with cores. Samples pushed by
+ * one producer for a channel are filtered in push order. Filtered samples are
+ * handed to a sink on the shard thread.
+ *
+ * `stats()` and `load_imbalance()` report how evenly the channel hash spreads
+ * the traffic over the shards.
+ *
+ * @tparam T - data type used by the filters
+ */
+template <typename T>
+class ShardedFilterBank {
+ public:
+  using Sink = std::function<void(int channel, T data_out)>;
+
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new Sharded Filter Bank object from any type of Filter
+   *
+   * @param filter - filter cloned onto every channel
+   * @param channels - number of channels
+   * @param shards - number of shard threads (0 for one per hardware thread)
+   * @param sink - called on the shard thread with every filtered sample
+   * @param queue_capacity - samples queued per shard before producers wait
+   */
+  ShardedFilterBank(Filter<T> const& filter, const int channels, int shards,
+                    Sink sink = {}, const std::size_t queue_capacity = 1 << 14)
+      : _sink{std::move(sink)} {
+    if (channels < 1) {
+      throw std::domain_error("Number of channels must be positive");
+    }
+    _filters.resize(channels);
+    if (shards <= 0) {
+      shards = std::max(1U, std::thread::hardware_concurrency());
+    }
+    for (auto& channel_filter : _filters) {
+      channel_filter = filter.clone();
+    }
+    for (int ss{0}; ss < shards; ++ss) {
+      _shards.push_back(std::make_unique<Shard>(queue_capacity));
+    }
+    for (int cc{0}; cc < channels; ++cc) {
+      ++_shards[shard_of(cc)]->channels;
+    }
+    try {
+      for (auto& shard : _shards) {
+        shard->worker =
+            std::thread{[this, raw = shard.get()]() { work(*raw); }};
+      }
+    } catch (...) {
+      stop();
+      throw;
+    }
+  }
+
+  ShardedFilterBank(const ShardedFilterBank&) = delete;
+  ShardedFilterBank& operator=(const ShardedFilterBank&) = delete;
+
+  /**
+   * @brief Filter everything already pushed, then stop the shard threads
+   *
+   */
+  ~ShardedFilterBank() {
+    drain();
+    stop();
+  }
+
+  // INGESTION FUNCTIONS *******************************************************
+
+  /**
+   * @brief Queue a sample for filtering, waiting while the shard is full.
+   * Safe from any number of threads.
+   *
+   * @param channel - channel index
+   * @param data_in - newest data point of the channel
+   * @throws std::out_of_range if the channel does not exist
+   */
+  void push(const int channel, const T data_in) {
+    if ((channel < 0) || (channel >= static_cast<int>(_filters.size()))) {
+      throw std::out_of_range("Channel " + std::to_string(channel) +
+                              " does not exist");
+    }
+    Shard& shard{*_shards[shard_of(channel)]};
+    if (shard.queue.try_push({channel, data_in})) {
+      return;
+    }
+    shard.full_waits.fetch_add(1, std::memory_order_relaxed);
+    while (!shard.queue.try_push({channel, data_in})) {
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * @brief Wait until every sample pushed so far has been filtered. If a
+   * filter or the sink threw on a shard thread since the last flush, the
+   * first exception is rethrown here; the other samples are still filtered.
+   *
+   */
+  void flush() {
+    drain();
+    std::exception_ptr error{nullptr};
+    {
+      std::lock_guard<std::mutex> lock{_error_mutex};
+      std::swap(error, _error);
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Shard that owns a channel
+   *
+   * @param channel - channel index
+   */
+  int shard_of(const int channel) const {
+    const std::uint32_t hash{static_cast<std::uint32_t>(channel) * 2654435769U};
+    return static_cast<int>((static_cast<std::uint64_t>(hash) *
+                             _shards.size()) >> 32);
+  }
+
+  /**
+   * @brief Number of shards
+   *
+   */
+  int shards() const { return static_cast<int>(_shards.size()); }
+
+  /**
+   * @brief Load statistics of every shard
+   *
+   */
+  std::vector<ShardStats> stats() const {
+    std::vector<ShardStats> result;
+    for (const auto& shard : _shards) {
+      ShardStats stat;
+      stat.samples = shard->processed.load(std::memory_order_relaxed);
+      stat.full_waits = shard->full_waits.load(std::memory_order_relaxed);
+      stat.max_depth = shard->max_depth.load(std::memory_order_relaxed);
+      stat.busy_ns = shard->busy_ns.load(std::memory_order_relaxed);
+      stat.channels = shard->channels;
+      result.push_back(stat);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Samples filtered by the busiest shard over the mean per shard,
+   * i.e. 1 for a perfectly even load and `shards()` if one shard gets all
+   *
+   */
+  double load_imbalance() const {
+    std::uint64_t total{0};
+    std::uint64_t busiest{0};
+    for (const auto& stat : stats()) {
+      total += stat.samples;
+      busiest = std::max(busiest, stat.samples);
+    }
+    return total == 0 ? 1.0
+                      : static_cast<double>(busiest) * _shards.size() / total;
+  }
+
+ private:
+  /**
+   * @brief A queued sample
+   *
+   */
+  struct Sample {
+    int channel{0};  ///< Channel index
+    T value{};       ///< Data point
+  };
+
+  /**
+   * @brief Queue, worker thread and counters of one shard
+   *
+   */
+  struct Shard {
+    Shard(const std::size_t capacity) : queue{capacity} {}
+
+    MpscQueue<Sample> queue;                   ///< Incoming samples
+    std::thread worker{};                      ///< Owning thread
+    std::atomic<bool> stopping{false};         ///< Set on destruction
+    std::atomic<std::uint64_t> processed{0};   ///< Samples filtered
+    std::atomic<std::uint64_t> full_waits{0};  ///< Producer stalls
+    std::atomic<std::uint64_t> max_depth{0};   ///< Deepest queue seen
+    std::atomic<std::uint64_t> busy_ns{0};     ///< Time spent filtering
+    int channels{0};                           ///< Channels owned
+  };
+
+  /**
+   * @brief Wait until every sample pushed so far has been filtered
+   *
+   */
+  void drain() {
+    for (auto& shard : _shards) {
+      const std::size_t pushed{shard->queue.pushed()};
+      while (shard->processed.load(std::memory_order_acquire) < pushed) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /**
+   * @brief Stop the shard threads that were started and join them
+   *
+   */
+  void stop() {
+    for (auto& shard : _shards) {
+      shard->stopping.store(true, std::memory_order_release);
+    }
+    for (auto& shard : _shards) {
+      if (shard->worker.joinable()) {
+        shard->worker.join();
+      }
+    }
+  }
+
+  /**
+   * @brief Shard thread: drain the queue in batches, back off when idle. A
+   * sample whose filter or sink throws still counts as processed, and the
+   * first exception is kept for `flush()`.
+   *
+   */
+  void work(Shard& shard) {
+    constexpr int kBatch{256};
+    int idle{0};
+    for (;;) {
+      const std::uint64_t depth{shard.queue.depth()};
+      if (depth > shard.max_depth.load(std::memory_order_relaxed)) {
+        shard.max_depth.store(depth, std::memory_order_relaxed);
+      }
+
+      const auto start{std::chrono::steady_clock::now()};
+      Sample sample;
+      int count{0};
+      while ((count < kBatch) && shard.queue.try_pop(sample)) {
+        ++count;
+        try {
+          T data_out;
+          _filters[sample.channel]->filter(sample.value, data_out);
+          if (_sink) {
+            _sink(sample.channel, data_out);
+          }
+        } catch (...) {
+          std::lock_guard<std::mutex> lock{_error_mutex};
+          if (!_error) {
+            _error = std::current_exception();
+          }
+        }
+      }
+
+      if (count > 0) {
+        const auto stop{std::chrono::steady_clock::now()};
+        shard.busy_ns.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+                .count(),
+            std::memory_order_relaxed);
+        shard.processed.fetch_add(count, std::memory_order_release);
+        idle = 0;
+      } else if (shard.stopping.load(std::memory_order_acquire)) {
+        return;
+      } else if (++idle < 64) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(std::chrono::microseconds{50});
+      }
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  std::vector<std::unique_ptr<Filter<T>>> _filters;  ///< One per channel
+  std::vector<std::unique_ptr<Shard>> _shards{};     ///< Shards and threads
+  Sink _sink;  ///< Receives every filtered sample
+  std::mutex _error_mutex{};           ///< Guards `_error`
+  std::exception_ptr _error{nullptr};  ///< First exception since a flush
+};
+
+#endif
@@ -12,10 +12,56 @@
 #ifndef MULTISTREAM_FILTER_HPP
 #define MULTISTREAM_FILTER_HPP
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <limits>
 #include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
 
+#include "filtering/dispatch.hpp"
 #include "filtering/filter.hpp"
+#include "filtering/gaps.hpp"
+
+/**
+ * @brief How a block of multi-channel frames is laid out in memory
+ *
+ * Interleaved blocks are row-major (frame after frame, one value per channel).
+ * Planar blocks are column-major (all of channel 0, then all of channel 1...).
+ */
+enum class SampleLayout { Interleaved, Planar };
+
+/**
+ * @brief Transpose a row-major `rows` x `cols` matrix into `data_out`
+ *
+ * The matrix is walked in square tiles so that both the reads and the strided
+ * writes of a tile stay in cache.
+ *
+ * @param data_in - row-major input matrix
+ * @param data_out - row-major `cols` x `rows` output matrix
+ * @param rows - number of rows of the input
+ * @param cols - number of columns of the input
+ */
+template <typename T>
+void transpose(const T* data_in, T* data_out, const int rows, const int cols) {
+  constexpr int kTile{16};
+  for (int r0{0}; r0 < rows; r0 += kTile) {
+    const int r1{std::min(r0 + kTile, rows)};
+    for (int c0{0}; c0 < cols; c0 += kTile) {
+      const int c1{std::min(c0 + kTile, cols)};
+      for (int rr{r0}; rr < r1; ++rr) {
+        for (int cc{c0}; cc < c1; ++cc) {
+          data_out[static_cast<long>(cc) * rows + rr] =
+              data_in[static_cast<long>(rr) * cols + cc];
+        }
+      }
+    }
+  }
+}
 
 /**
  * @brief MultiStreamFilter - filter multi-stream incoming data
@@ -73,6 +119,40 @@ class MultiStreamFilter {
     }
   }
 
+  /**
+   * @brief Filter a block of frames, N values per frame
+   *
+   * Each stream is filtered by one `filter_block` call over time, which keeps
+   * the filter state in registers and lets block formulations (FIR, moving
+   * average, ...) kick in. Planar blocks are filtered without any copy;
+   * interleaved blocks are transposed to planar scratch buffers and back in
+   * cache-sized tiles.
+   *
+   * @param data_in - `frames` x N input values
+   * @param data_out - `frames` x N output values, in the same layout
+   * @param frames - number of frames in the block
+   * @param layout - memory layout of both blocks
+   */
+  void filter_frames(const T* data_in, T* data_out, const int frames,
+                     const SampleLayout layout) {
+    if (layout == SampleLayout::Planar) {
+      for (int ii{0}; ii < N; ++ii) {
+        const long offset{static_cast<long>(ii) * frames};
+        _filters[ii]->filter_block(data_in + offset, data_out + offset,
+                                   frames);
+      }
+      return;
+    }
+
+    const long values{static_cast<long>(N) * frames};
+    _planar_in.resize(values);
+    _planar_out.resize(values);
+    transpose(data_in, _planar_in.data(), frames, N);
+    filter_frames(_planar_in.data(), _planar_out.data(), frames,
+                  SampleLayout::Planar);
+    transpose(_planar_out.data(), data_out, N, frames);
+  }
+
   /**
    * @brief Reset the filters
    *
@@ -83,6 +163,17 @@ class MultiStreamFilter {
     }
   }
 
+  /**
+   * @brief Seed each filter with the steady state for a constant input
+   *
+   * @param values - the constant input of each stream
+   */
+  void seed(const std::array<T, N> values) {
+    for (int ii{0}; ii < N; ++ii) {
+      _filters[ii]->seed(values[ii]);
+    }
+  }
+
   /**
    * @brief Set the filter sizes.
    *
@@ -94,10 +185,416 @@ class MultiStreamFilter {
     }
   };
 
+  /**
+   * @brief Access the filter applied to one stream
+   *
+   * @param ind - stream index
+   * @return Filter<T>& - that stream's filter
+   */
+  Filter<T>& stream(const int ind) { return *_filters[ind]; }
+
  private:
   // VARIABLES *****************************************************************
   std::array<std::unique_ptr<Filter<T>>, N>
       _filters;  ///< Array of pts to the controller filters
+  std::vector<T> _planar_in{};   ///< Interleaved input block, transposed
+  std::vector<T> _planar_out{};  ///< Planar output, before transposing back
+};
+
+// EXPONENTIAL FILTER BANK *****************************************************
+
+/**
+ * @brief Exponential filter applied to N streams
+ *
+ * The bank stores the filter constants and states as arrays, so a frame is
+ * filtered with one loop across channels that vectorizes (compiled for the
+ * CPU's instruction set, see dispatch.hpp). `filter_frames` picks the loop
+ * order from the layout: interleaved blocks run across channels for each
+ * frame over contiguous memory, while planar blocks run over time for a tile
+ * of channels at once, so that the independent recurrences overlap instead of
+ * waiting on each other.
+ *
+ * After `set_gap_policy`, blocks containing NaN samples go through a
+ * select-based loop that applies the GapPolicy per stream (Interpolate, which
+ * needs to see ahead, is held as in GapFilter::filter); blocks without gaps
+ * keep the fast paths after one scan.
+ *
+ * @tparam T - type of each incoming data stream
+ * @tparam N - number of data streams
+ * @tparam P - Precision policy for the filter constants and states
+ */
+template <typename T, int N, typename P = Precision<T>>
+class ExponentialFilterBank {
+ public:
+  using Coefficient = typename P::coefficient_type;
+  using Accumulator = typename P::accumulator_type;
+
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new Exponential Filter Bank with one filter constant
+   *
+   * @param filter_constant - constant used by every stream
+   */
+  ExponentialFilterBank(const Coefficient filter_constant) {
+    std::array<Coefficient, N> filter_constants;
+    filter_constants.fill(filter_constant);
+    set_filter_constants(filter_constants);
+  }
+
+  /**
+   * @brief Construct a new Exponential Filter Bank with one filter constant
+   * per stream. @overload
+   *
+   * @param filter_constants - constant used by each stream
+   */
+  ExponentialFilterBank(const std::array<Coefficient, N>& filter_constants) {
+    set_filter_constants(filter_constants);
+  }
+
+  // FILTER FUNCTIONS **********************************************************
+
+  /**
+   * @brief Filter one frame of data, one point per stream
+   *
+   * @param data_in - newest point of every stream
+   * @param data_out - filtered output of every stream
+   */
+  void filter(const std::array<T, N>& data_in, std::array<T, N>& data_out) {
+    filter_frames(data_in.data(), data_out.data(), 1,
+                  SampleLayout::Interleaved);
+  }
+
+  /**
+   * @brief Filter a block of frames, N values per frame
+   *
+   * @param data_in - `frames` x N input values
+   * @param data_out - `frames` x N output values, in the same layout
+   * @param frames - number of frames in the block
+   * @param layout - memory layout of both blocks
+   */
+  void filter_frames(const T* data_in, T* data_out, const int frames,
+                     const SampleLayout layout) {
+    if (_gaps_handled && (frames > 0)) {
+      if (has_gaps(data_in, static_cast<long>(N) * frames)) {
+        filter_gaps(data_in, data_out, frames, layout);
+        return;
+      }
+      for (int cc{0}; cc < N; ++cc) {
+        _last_valid[cc] = layout == SampleLayout::Interleaved
+                              ? data_in[static_cast<long>(frames - 1) * N + cc]
+                              : data_in[static_cast<long>(cc + 1) * frames - 1];
+      }
+    }
+    if (layout == SampleLayout::Interleaved) {
+      exponential_bank(_alpha.data(), _one_minus_alpha.data(),
+                       _filtered_data.data(), data_in, data_out, N, frames);
+      return;
+    }
+
+    for (int c0{0}; c0 < N; c0 += kTile) {
+      const int tile{std::min(kTile, N - c0)};
+      std::array<Accumulator, kTile> y{};
+      for (int cc{0}; cc < tile; ++cc) {
+        y[cc] = _filtered_data[c0 + cc];
+      }
+      const T* tile_in{data_in + static_cast<long>(c0) * frames};
+      T* tile_out{data_out + static_cast<long>(c0) * frames};
+      for (int ff{0}; ff < frames; ++ff) {
+        for (int cc{0}; cc < tile; ++cc) {
+          const long ind{static_cast<long>(cc) * frames + ff};
+          y[cc] = _alpha[c0 + cc] * static_cast<Accumulator>(tile_in[ind]) +
+                  _one_minus_alpha[c0 + cc] * y[cc];
+          tile_out[ind] = static_cast<T>(y[cc]);
+        }
+      }
+      for (int cc{0}; cc < tile; ++cc) {
+        _filtered_data[c0 + cc] = y[cc];
+      }
+    }
+  }
+
+  /**
+   * @brief Reset the filters by setting the filtered data to ZERO
+   *
+   */
+  void reset() {
+    _filtered_data.fill(0);
+    _last_valid.fill(0);
+  }
+
+  /**
+   * @brief Start each filter at the steady state for a constant input
+   *
+   * @param values - the constant input of each stream
+   */
+  void seed(const std::array<T, N>& values) {
+    for (int cc{0}; cc < N; ++cc) {
+      _filtered_data[cc] = static_cast<Accumulator>(values[cc]);
+      _last_valid[cc] = values[cc];
+    }
+  }
+
+  /**
+   * @brief Handle missing (NaN) samples according to a policy instead of
+   * letting them poison the states
+   *
+   * @param policy - handling of NaN samples
+   */
+  void set_gap_policy(const GapPolicy policy) {
+    _gap_policy = policy;
+    _gaps_handled = true;
+  }
+
+  /**
+   * @brief Set the filter constant of each stream
+   *
+   * @param filter_constants - constant used by each stream
+   */
+  void set_filter_constants(
+      const std::array<Coefficient, N>& filter_constants) {
+    for (int cc{0}; cc < N; ++cc) {
+      if ((filter_constants[cc] <= 0) || (filter_constants[cc] > 1)) {
+        throw std::domain_error("Filter constant must be in the range (0, 1]");
+      }
+      _alpha[cc] = static_cast<Accumulator>(filter_constants[cc]);
+      _one_minus_alpha[cc] = 1 - _alpha[cc];
+    }
+  }
+
+ private:
+  /**
+   * @brief Filter a block containing gaps: missing samples are replaced by
+   * the stream's last valid sample, Skip keeps the state instead of updating
+   * it, and MarkInvalid outputs NaN for them
+   *
+   */
+  void filter_gaps(const T* data_in, T* data_out, const int frames,
+                   const SampleLayout layout) {
+    const bool skip{_gap_policy == GapPolicy::Skip};
+    const bool mark{_gap_policy == GapPolicy::MarkInvalid};
+    const bool planar{layout == SampleLayout::Planar};
+    for (int ff{0}; ff < frames; ++ff) {
+      for (int cc{0}; cc < N; ++cc) {
+        const long ind{planar ? static_cast<long>(cc) * frames + ff
+                              : static_cast<long>(ff) * N + cc};
+        const bool valid{!is_gap(data_in[ind])};
+        _last_valid[cc] = valid ? data_in[ind] : _last_valid[cc];
+        const Accumulator updated{
+            _alpha[cc] * static_cast<Accumulator>(_last_valid[cc]) +
+            _one_minus_alpha[cc] * _filtered_data[cc]};
+        _filtered_data[cc] = skip && !valid ? _filtered_data[cc] : updated;
+        data_out[ind] = mark && !valid ? kGap
+                                       : static_cast<T>(_filtered_data[cc]);
+      }
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  static constexpr int kTile{8};  ///< Channels filtered together when planar
+  static constexpr T kGap{std::numeric_limits<T>::quiet_NaN()};
+
+  std::array<Accumulator, N> _alpha{};            ///< Filter constants
+  std::array<Accumulator, N> _one_minus_alpha{};  ///< 1 - filter constants
+  std::array<Accumulator, N> _filtered_data{};    ///< Filter states
+  std::array<T, N> _last_valid{};                 ///< Last valid samples
+  GapPolicy _gap_policy{GapPolicy::Hold};         ///< Handling of NaN samples
+  bool _gaps_handled{false};                      ///< Was a gap policy set?
+};
+
+// HETEROGENEOUS MULTI-STREAM FILTER *******************************************
+
+/**
+ * @brief HeterogeneousMultiStreamFilter - filter multi-stream data with a
+ * different filter type per stream, without heap allocation or virtual calls
+ *
+ * The filter types are listed up front and each stream holds a
+ * std::variant of them, so all N filters live inline in one contiguous
+ * array. The filters are stored grouped by type, and `filter` walks one
+ * group at a time calling the concrete type's `filter` directly (a
+ * qualified, non-virtual call the compiler can inline), so a stream costs
+ * no pointer chase and no per-sample dispatch.
+ *
+ *    HeterogeneousMultiStreamFilter<double, 3, LowPassFilter<double>,
+ *                                   MovingAverageFilter<double>>
+ *        m{{LowPassFilter<double>{0.1}, MovingAverageFilter<double>{20},
+ *           LowPassFilter<double>{0.2}}};
+ *
+ * @tparam T - type of each incoming data stream (aka double, int)
+ * @tparam N - number of data streams
+ * @tparam Filters - the Filter sub-types that streams may use
+ */
+template <typename T, int N, typename... Filters>
+class HeterogeneousMultiStreamFilter {
+  static_assert(sizeof...(Filters) >= 1, "At least one filter type needed");
+  static_assert((std::is_base_of_v<Filter<T>, Filters> && ...),
+                "Every filter type must derive from Filter<T>");
+
+ public:
+  using Variant = std::variant<Filters...>;
+
+  // CONSTRUCTOR ***************************************************************
+
+  /**
+   * @brief Construct a new Heterogeneous Multi Stream Filter object
+   *
+   * @param filters - the filter of each stream, in stream order
+   */
+  HeterogeneousMultiStreamFilter(const std::array<Variant, N>& filters)
+      : _streams{group_by_type(filters)},
+        _filters{gather(filters, _streams, std::make_index_sequence<N>{})} {
+    for (int kk{0}; kk < N; ++kk) {
+      _slots[_streams[kk]] = kk;
+    }
+    for (std::size_t gg{0}; gg <= sizeof...(Filters); ++gg) {
+      _group_begin[gg] = static_cast<int>(
+          std::count_if(filters.begin(), filters.end(),
+                        [&](const Variant& f) { return f.index() < gg; }));
+    }
+  }
+
+  // FILTER FUNCTIONS **********************************************************
+
+  /**
+   * @brief Filter the data stream by applying the internal filters
+   *
+   * @param data_in
+   * @param data_out
+   */
+  void filter(const std::array<T, N>& data_in, std::array<T, N>& data_out) {
+    filter_groups(data_in, data_out,
+                  std::make_index_sequence<sizeof...(Filters)>{});
+  }
+
+  /**
+   * @brief Reset the filters
+   *
+   */
+  void reset() {
+    for (auto& filter : _filters) {
+      std::visit([](auto& f) { f.reset(); }, filter);
+    }
+  }
+
+  /**
+   * @brief Seed each filter with the steady state for a constant input
+   *
+   * @param values - the constant input of each stream
+   */
+  void seed(const std::array<T, N>& values) {
+    for (int kk{0}; kk < N; ++kk) {
+      const T value{values[_streams[kk]]};
+      std::visit([&](auto& f) { f.seed(value); }, _filters[kk]);
+    }
+  }
+
+  /**
+   * @brief Set the filter sizes.
+   *
+   * @param size
+   */
+  void set_filter_size(const int size) {
+    for (auto& filter : _filters) {
+      std::visit([&](auto& f) { f.set_filter_size(size); }, filter);
+    }
+  }
+
+  /**
+   * @brief Access the filter applied to one stream
+   *
+   * @param ind - stream index
+   * @return Filter<T>& - that stream's filter
+   */
+  Filter<T>& stream(const int ind) {
+    return std::visit([](auto& f) -> Filter<T>& { return f; },
+                      _filters[_slots[ind]]);
+  }
+
+ private:
+  // PRIVATE SUPPORT FUNCTIONS *************************************************
+
+  /**
+   * @brief Stream indices ordered by filter type, keeping stream order within
+   * each type
+   *
+   */
+  static std::array<int, N> group_by_type(
+      const std::array<Variant, N>& filters) {
+    std::array<int, N> streams{};
+    for (int ii{0}; ii < N; ++ii) {
+      streams[ii] = ii;
+    }
+    std::stable_sort(streams.begin(), streams.end(), [&](int lhs, int rhs) {
+      return filters[lhs].index() < filters[rhs].index();
+    });
+    return streams;
+  }
+
+  /**
+   * @brief Copy the filters into grouped order
+   *
+   */
+  template <std::size_t... I>
+  static std::array<Variant, N> gather(const std::array<Variant, N>& filters,
+                                       const std::array<int, N>& streams,
+                                       std::index_sequence<I...>) {
+    return {filters[streams[I]]...};
+  }
+
+  /**
+   * @brief Filter every group in turn
+   *
+   */
+  template <std::size_t... G>
+  void filter_groups(const std::array<T, N>& data_in,
+                     std::array<T, N>& data_out, std::index_sequence<G...>) {
+    (filter_group<G>(data_in, data_out), ...);
+  }
+
+  /**
+   * @brief Filter the streams whose filter is alternative G of the variant
+   *
+   */
+  template <std::size_t G>
+  void filter_group(const std::array<T, N>& data_in,
+                    std::array<T, N>& data_out) {
+    using Group = std::variant_alternative_t<G, Variant>;
+    for (int kk{_group_begin[G]}; kk < _group_begin[G + 1]; ++kk) {
+      Group& filter{*std::get_if<G>(&_filters[kk])};
+      const int ii{_streams[kk]};
+      filter.Group::filter(data_in[ii], data_out[ii]);
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  std::array<int, N> _streams;      ///< Stream index of each stored filter
+  std::array<Variant, N> _filters;  ///< Filters, grouped by type
+  std::array<int, N> _slots{};      ///< Storage index of each stream's filter
+  std::array<int, sizeof...(Filters) + 1>
+      _group_begin{};  ///< First storage index of each type, plus N
 };
 
+// EXPLICIT INSTANTIATIONS *****************************************************
+
+/**
+ * @brief Compiled into filtering_static/filtering_shared, see filter.hpp
+ *
+ */
+#ifdef FILTERING_EXTERN_TEMPLATES
+#define FILTERING_EXTERN_BANKS(N)                         \
+  extern template class MultiStreamFilter<float, N>;      \
+  extern template class MultiStreamFilter<double, N>;     \
+  extern template class ExponentialFilterBank<float, N>;  \
+  extern template class ExponentialFilterBank<double, N>;
+FILTERING_EXTERN_BANKS(2)
+FILTERING_EXTERN_BANKS(4)
+FILTERING_EXTERN_BANKS(8)
+FILTERING_EXTERN_BANKS(16)
+FILTERING_EXTERN_BANKS(32)
+FILTERING_EXTERN_BANKS(64)
+#undef FILTERING_EXTERN_BANKS
+#endif
+
 #endif
\ No newline at end of file
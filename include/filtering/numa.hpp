@@ -0,0 +1,477 @@
+/**
+ * @file numa.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief NUMA-aware filter banks with node-local state and pinned workers
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef NUMA_FILTER_HPP
+#define NUMA_FILTER_HPP
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "filtering/aligned.hpp"
+#include "filtering/filter.hpp"
+
+// TOPOLOGY ********************************************************************
+
+/**
+ * @brief The CPUs of each NUMA node
+ *
+ */
+struct NumaTopology {
+  std::vector<std::vector<int>> cpus{};  ///< CPU ids of each node
+
+  /**
+   * @brief Number of nodes
+   *
+   */
+  int nodes() const { return static_cast<int>(cpus.size()); }
+
+  /**
+   * @brief A single node holding every hardware thread, used where there is
+   * no NUMA information
+   *
+   */
+  static NumaTopology single_node() {
+    NumaTopology topology;
+    topology.cpus.emplace_back();
+    const int threads{
+        static_cast<int>(std::max(1U, std::thread::hardware_concurrency()))};
+    for (int ii{0}; ii < threads; ++ii) {
+      topology.cpus[0].push_back(ii);
+    }
+    return topology;
+  }
+
+  /**
+   * @brief Read the nodes that have CPUs from /sys/devices/system/node, or
+   * fall back to a single node
+   *
+   * @param root - sysfs node directory, for testing
+   */
+  static NumaTopology detect(
+      const std::string& root = "/sys/devices/system/node") {
+    std::vector<std::pair<int, std::vector<int>>> found;
+    std::error_code error;
+    for (const auto& entry :
+         std::filesystem::directory_iterator{root, error}) {
+      const std::string name{entry.path().filename().string()};
+      if ((name.size() <= 4) || (name.compare(0, 4, "node") != 0) ||
+          !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+        continue;
+      }
+      std::ifstream file{entry.path() / "cpulist"};
+      std::string list;
+      if (std::getline(file, list)) {
+        std::vector<int> node_cpus{parse_cpu_list(list)};
+        if (!node_cpus.empty()) {
+          found.emplace_back(std::stoi(name.substr(4)), std::move(node_cpus));
+        }
+      }
+    }
+    if (found.empty()) {
+      return single_node();
+    }
+
+    std::sort(found.begin(), found.end());
+    NumaTopology topology;
+    for (auto& node : found) {
+      topology.cpus.push_back(std::move(node.second));
+    }
+    return topology;
+  }
+
+  /**
+   * @brief Parse a kernel CPU list such as "0-3,8-11"
+   *
+   */
+  static std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> result;
+    std::stringstream stream{list};
+    for (std::string range; std::getline(stream, range, ',');) {
+      if (range.find_first_of("0123456789") == std::string::npos) {
+        continue;
+      }
+      const std::size_t dash{range.find('-')};
+      const int first{std::stoi(range.substr(0, dash))};
+      const int last{dash == std::string::npos
+                         ? first
+                         : std::stoi(range.substr(dash + 1))};
+      for (int cpu{first}; cpu <= last; ++cpu) {
+        result.push_back(cpu);
+      }
+    }
+    return result;
+  }
+};
+
+/**
+ * @brief Restrict the calling thread to a set of CPUs. Does nothing where
+ * thread affinity is not supported.
+ *
+ * @param cpus - CPU ids the thread may run on
+ * @return true - the thread was pinned
+ */
+inline bool pin_current_thread(const std::vector<int>& cpus) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const int cpu : cpus) {
+    if ((cpu >= 0) && (cpu < CPU_SETSIZE)) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpus;
+  return false;
+#endif
+}
+
+// NUMA FILTER BANK ************************************************************
+
+/**
+ * @brief Multi-channel filter bank whose state lives on the NUMA node of the
+ * thread that updates it
+ *
+ * Channels are split into contiguous partitions, one per worker thread, and
+ * the workers are spread evenly over the nodes and pinned to their node's
+ * CPUs. Each worker clones its channels' filters and allocates its part of
+ * the input and output buffers itself, so with the kernel's first-touch
+ * policy all of a channel's memory is on the node that filters it and is
+ * never written from another socket.
+ *
+ * Producers write straight into node-local memory through `input(channel)`,
+ * a planar row of `capacity()` frames, then `run(frames)` filters every
+ * partition in parallel into `output(channel)`. `filter_frames` does the same
+ * from a caller-owned planar block, with each worker reading its own slice.
+ *
+ * On a machine without NUMA the topology is a single node and the bank
+ * behaves like a plain multi-threaded bank.
+ *
+ * @tparam T - data type used by the filters
+ */
+template <typename T>
+class NumaFilterBank {
+ public:
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new NUMA Filter Bank object from any type of Filter
+   *
+   * @param filter - filter cloned onto every channel
+   * @param channels - number of channels
+   * @param capacity - frames held by the node-local buffers
+   * @param threads_per_node - worker threads on each node
+   * @param topology - nodes and their CPUs
+   */
+  NumaFilterBank(Filter<T> const& filter, const int channels,
+                 const int capacity, const int threads_per_node = 1,
+                 NumaTopology topology = NumaTopology::detect())
+      : _channels{channels}, _capacity{capacity}, _topology{topology} {
+    if ((channels < 1) || (capacity < 1) || (threads_per_node < 1)) {
+      throw std::domain_error(
+          "Channels, capacity and threads per node must be positive");
+    }
+    if (_topology.nodes() < 1) {
+      _topology = NumaTopology::single_node();
+    }
+
+    const int workers{std::min(channels, _topology.nodes() * threads_per_node)};
+    for (int ww{0}; ww < workers; ++ww) {
+      auto worker{std::make_unique<Worker>()};
+      worker->node = ww * _topology.nodes() / workers;
+      worker->begin = static_cast<int>(static_cast<long>(channels) * ww /
+                                       workers);
+      worker->end = static_cast<int>(static_cast<long>(channels) * (ww + 1) /
+                                     workers);
+      _workers.push_back(std::move(worker));
+    }
+    for (int cc{0}; cc < channels; ++cc) {
+      _owner.push_back(worker_of(cc));
+    }
+
+    try {
+      for (auto& worker : _workers) {
+        worker->thread =
+            std::thread{[this, raw = worker.get()]() { work(*raw); }};
+      }
+      // First touch: each worker allocates its own state on its own node
+      dispatch([&filter, this](Worker& worker) {
+        const int count{worker.end - worker.begin};
+        for (int cc{0}; cc < count; ++cc) {
+          worker.filters.push_back(filter.clone());
+        }
+        worker.input.assign(static_cast<std::size_t>(count) * _capacity, T{0});
+        worker.output.assign(static_cast<std::size_t>(count) * _capacity,
+                             T{0});
+      });
+    } catch (...) {
+      stop();
+      throw;
+    }
+  }
+
+  NumaFilterBank(const NumaFilterBank&) = delete;
+  NumaFilterBank& operator=(const NumaFilterBank&) = delete;
+
+  /**
+   * @brief Stop the workers
+   *
+   */
+  ~NumaFilterBank() { stop(); }
+
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Filter the first `frames` frames of every node-local input buffer
+   * into the output buffers
+   *
+   * @param frames - number of frames, at most `capacity()`
+   */
+  void run(const int frames) {
+    if ((frames < 0) || (frames > _capacity)) {
+      throw std::domain_error("Frames must be in the range [0, capacity]");
+    }
+    dispatch([frames, this](Worker& worker) {
+      for (int cc{0}; cc < worker.end - worker.begin; ++cc) {
+        const std::size_t row{static_cast<std::size_t>(cc) * _capacity};
+        worker.filters[cc]->filter_block(worker.input.data() + row,
+                                         worker.output.data() + row, frames);
+      }
+    });
+  }
+
+  /**
+   * @brief Filter a caller-owned planar block (channel after channel, each
+   * `frames` long). Each worker reads and writes only its own channels.
+   *
+   * @param data_in - pointer to channels * frames incoming data points
+   * @param data_out - pointer to where the filtered data is written
+   * @param frames - number of frames
+   */
+  void filter_frames(const T* data_in, T* data_out, const int frames) {
+    if (frames < 0) {
+      throw std::domain_error("Number of frames must not be negative");
+    }
+    dispatch([data_in, data_out, frames](Worker& worker) {
+      for (int cc{worker.begin}; cc < worker.end; ++cc) {
+        const std::size_t row{static_cast<std::size_t>(cc) * frames};
+        worker.filters[cc - worker.begin]->filter_block(
+            data_in + row, data_out + row, frames);
+      }
+    });
+  }
+
+  /**
+   * @brief Reset the filters of every channel
+   *
+   */
+  void reset() {
+    dispatch([](Worker& worker) {
+      for (auto& filter : worker.filters) {
+        filter->reset();
+      }
+    });
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Node-local input buffer of a channel, `capacity()` frames long
+   *
+   * @param channel - channel index
+   */
+  T* input(const int channel) {
+    Worker& worker{*_workers[_owner[channel]]};
+    return worker.input.data() +
+           static_cast<std::size_t>(channel - worker.begin) * _capacity;
+  }
+  /**
+   * @brief Node-local output buffer of a channel, filled by `run`
+   *
+   * @param channel - channel index
+   */
+  const T* output(const int channel) const {
+    const Worker& worker{*_workers[_owner[channel]]};
+    return worker.output.data() +
+           static_cast<std::size_t>(channel - worker.begin) * _capacity;
+  }
+  /**
+   * @brief Filter of a channel. Only use it while the bank is idle.
+   *
+   * @param channel - channel index
+   */
+  Filter<T>& filter(const int channel) {
+    Worker& worker{*_workers[_owner[channel]]};
+    return *worker.filters[channel - worker.begin];
+  }
+  /**
+   * @brief NUMA node whose memory and CPUs serve a channel
+   *
+   * @param channel - channel index
+   */
+  int node_of(const int channel) const {
+    return _workers[_owner[channel]]->node;
+  }
+  /**
+   * @brief Did every worker manage to pin itself to its node?
+   *
+   */
+  bool pinned() const {
+    return std::all_of(_workers.begin(), _workers.end(),
+                       [](const auto& worker) { return worker->pinned; });
+  }
+
+  int channels() const { return _channels; }
+  int capacity() const { return _capacity; }
+  int workers() const { return static_cast<int>(_workers.size()); }
+  const NumaTopology& topology() const { return _topology; }
+
+ private:
+  /**
+   * @brief A worker thread and the channels it owns
+   *
+   */
+  struct alignas(kCacheLineSize) Worker {
+    std::thread thread{};  ///< The pinned thread
+    int node{0};           ///< NUMA node of the thread and its memory
+    int begin{0};          ///< First channel owned
+    int end{0};            ///< One past the last channel owned
+    bool pinned{false};    ///< Was the thread pinned to its node?
+    long generation{0};    ///< Last job run
+
+    std::vector<std::unique_ptr<Filter<T>>> filters{};  ///< Channel filters
+    std::vector<T> input{};   ///< Node-local planar input rows
+    std::vector<T> output{};  ///< Node-local planar output rows
+  };
+
+  /**
+   * @brief Worker owning a channel, from the contiguous partition
+   *
+   */
+  int worker_of(const int channel) const {
+    int ww{0};
+    while (channel >= _workers[ww]->end) {
+      ++ww;
+    }
+    return ww;
+  }
+
+  /**
+   * @brief Run a job on every worker and wait for all of them to finish. If
+   * the job throws on any worker, the first exception is rethrown here.
+   *
+   */
+  void dispatch(std::function<void(Worker&)> job) {
+    std::unique_lock<std::mutex> lock{_mutex};
+    _job = std::move(job);
+    _done = 0;
+    ++_generation;
+    _start.notify_all();
+    _finished.wait(lock, [this]() { return _done == workers(); });
+    _job = nullptr;
+    if (_error) {
+      std::exception_ptr error{nullptr};
+      std::swap(error, _error);
+      std::rethrow_exception(error);
+    }
+  }
+
+  /**
+   * @brief Stop and join the worker threads that were started
+   *
+   */
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _stopping = true;
+    }
+    _start.notify_all();
+    for (auto& worker : _workers) {
+      if (worker->thread.joinable()) {
+        worker->thread.join();
+      }
+    }
+  }
+
+  /**
+   * @brief Worker thread: pin to the node, then run each dispatched job
+   *
+   */
+  void work(Worker& worker) {
+    worker.pinned = (_topology.nodes() == 1) ||
+                    pin_current_thread(_topology.cpus[worker.node]);
+    for (;;) {
+      std::function<void(Worker&)>* job;
+      {
+        std::unique_lock<std::mutex> lock{_mutex};
+        _start.wait(lock, [this, &worker]() {
+          return _stopping || (_generation != worker.generation);
+        });
+        if (_stopping) {
+          return;
+        }
+        worker.generation = _generation;
+        job = &_job;
+      }
+      std::exception_ptr error{nullptr};
+      try {
+        (*job)(worker);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      {
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (error && !_error) {
+          _error = error;
+        }
+        ++_done;
+      }
+      _finished.notify_one();
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  int _channels;           ///< Number of channels
+  int _capacity;           ///< Frames held by the node-local buffers
+  NumaTopology _topology;  ///< Nodes and their CPUs
+
+  std::vector<std::unique_ptr<Worker>> _workers{};  ///< One per thread
+  std::vector<int> _owner{};                        ///< Worker of each channel
+
+  std::mutex _mutex{};                  ///< Guards the job state
+  std::condition_variable _start{};     ///< Signals a new job
+  std::condition_variable _finished{};  ///< Signals a finished worker
+  std::function<void(Worker&)> _job{};  ///< Current job
+  long _generation{0};                  ///< Number of jobs dispatched
+  int _done{0};                         ///< Workers finished with the job
+  std::exception_ptr _error{nullptr};   ///< First exception of the job
+  bool _stopping{false};                ///< Set on destruction
+};
+
+#endif
@@ -0,0 +1,404 @@
+/**
+ * @file pipeline.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Coroutine streaming pipelines of filters (requires C++20)
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef FILTER_PIPELINE_HPP
+#define FILTER_PIPELINE_HPP
+
+#if (__cplusplus >= 202002L) && __has_include(<coroutine>)
+
+#include <algorithm>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "filtering/filter.hpp"
+
+// BLOCK STREAM ****************************************************************
+
+/**
+ * @brief A lazily evaluated stream of blocks, produced by a coroutine
+ *
+ * A stage is a coroutine returning BlockStream<T> that `co_yield`s spans of
+ * data. Each span points into the producing stage's own buffer (or straight
+ * into the source data) and stays valid until the consumer asks for the next
+ * block, so blocks are never copied between stages. Streams are pull-based:
+ * a stage only runs when the stage after it wants a block, which gives
+ * backpressure for free - a slow sink simply pulls less often.
+ *
+ *    for (std::span<const double> block : stream) { ... }
+ *
+ * @tparam T - data type of the stream
+ */
+template <typename T>
+class BlockStream {
+ public:
+  struct promise_type;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  /**
+   * @brief Coroutine promise holding the most recently yielded block
+   *
+   */
+  struct promise_type {
+    std::span<const T> block{};
+    std::exception_ptr error{nullptr};
+
+    BlockStream get_return_object() {
+      return BlockStream{Handle::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    std::suspend_always yield_value(std::span<const T> value) noexcept {
+      block = value;
+      return {};
+    }
+    void return_void() noexcept {}
+    void unhandled_exception() { error = std::current_exception(); }
+  };
+
+  /**
+   * @brief Input iterator over the blocks of a stream
+   *
+   */
+  class Iterator {
+   public:
+    explicit Iterator(const Handle handle) : _handle{handle} {}
+
+    std::span<const T> operator*() const { return _handle.promise().block; }
+    Iterator& operator++() {
+      advance(_handle);
+      return *this;
+    }
+    bool operator==(std::default_sentinel_t) const {
+      return !_handle || _handle.done();
+    }
+
+   private:
+    Handle _handle;
+  };
+
+  // CONSTRUCTORS **************************************************************
+
+  explicit BlockStream(const Handle handle) : _handle{handle} {}
+  BlockStream(BlockStream&& other) noexcept
+      : _handle{std::exchange(other._handle, nullptr)} {}
+  BlockStream(const BlockStream&) = delete;
+  BlockStream& operator=(const BlockStream&) = delete;
+  BlockStream& operator=(BlockStream&& other) noexcept {
+    std::swap(_handle, other._handle);
+    return *this;
+  }
+  ~BlockStream() {
+    if (_handle) {
+      _handle.destroy();
+    }
+  }
+
+  // ITERATION *****************************************************************
+
+  /**
+   * @brief Run the stream up to its first block
+   *
+   */
+  Iterator begin() {
+    advance(_handle);
+    return Iterator{_handle};
+  }
+  std::default_sentinel_t end() const { return {}; }
+
+ private:
+  /**
+   * @brief Resume the producing coroutine, rethrowing anything it threw
+   *
+   */
+  static void advance(const Handle handle) {
+    handle.resume();
+    if (handle.promise().error) {
+      std::rethrow_exception(handle.promise().error);
+    }
+  }
+
+  Handle _handle;  ///< The producing coroutine
+};
+
+// PIPELINE STAGES *************************************************************
+
+/**
+ * @brief Source stage: split contiguous data into blocks without copying it
+ *
+ * @param data - the whole input, e.g. a memory-mapped file
+ * @param block_size - number of points per block (the last may be shorter)
+ */
+template <typename T>
+BlockStream<T> blocks_of(const std::span<const T> data, const int block_size) {
+  if (block_size < 1) {
+    throw std::domain_error("Block size must be positive");
+  }
+  for (std::size_t start{0}; start < data.size(); start += block_size) {
+    co_yield data.subspan(start, std::min<std::size_t>(block_size,
+                                                       data.size() - start));
+  }
+}
+
+/**
+ * @brief Source stage: pull blocks from an acquisition function
+ *
+ * @param read - callable `int(T* buffer, int capacity)` that fills the buffer
+ * and returns the number of points written, 0 at the end of the data
+ * @param block_size - capacity of each block
+ */
+template <typename T, typename Read>
+BlockStream<T> acquire(Read read, const int block_size) {
+  if (block_size < 1) {
+    throw std::domain_error("Block size must be positive");
+  }
+  std::vector<T> buffer(block_size);
+  for (int size{read(buffer.data(), block_size)}; size > 0;
+       size = read(buffer.data(), block_size)) {
+    co_yield std::span<const T>{buffer.data(), static_cast<std::size_t>(size)};
+  }
+}
+
+/**
+ * @brief Filter stage: run each block through a filter's block path
+ *
+ * The filter is used by reference, so its state can be inspected or seeded
+ * from outside and carries over from block to block.
+ *
+ * @param input - upstream stage
+ * @param filter - filter (or FilterChain) applied to the stream
+ */
+template <typename T>
+BlockStream<T> filter_blocks(BlockStream<T> input, Filter<T>& filter) {
+  std::vector<T> buffer;
+  for (const std::span<const T> block : input) {
+    buffer.resize(block.size());
+    filter.filter_block(block.data(), buffer.data(),
+                        static_cast<int>(block.size()));
+    co_yield std::span<const T>{buffer.data(), block.size()};
+  }
+}
+
+/**
+ * @brief Decimation stage: keep one point out of every `factor`
+ *
+ * The phase carries over from block to block, so the output is the same
+ * whatever the block size. Blocks that keep no point are not yielded.
+ *
+ * @param input - upstream stage, normally low-pass filtered
+ * @param factor - decimation factor
+ */
+template <typename T>
+BlockStream<T> decimate(BlockStream<T> input, const int factor) {
+  if (factor < 1) {
+    throw std::domain_error("Decimation factor must be positive");
+  }
+  std::vector<T> buffer;
+  std::size_t phase{0};
+  for (const std::span<const T> block : input) {
+    buffer.clear();
+    for (std::size_t ii{phase}; ii < block.size(); ii += factor) {
+      buffer.push_back(block[ii]);
+    }
+    phase = (phase + factor - block.size() % factor) % factor;
+    if (!buffer.empty()) {
+      co_yield std::span<const T>{buffer.data(), buffer.size()};
+    }
+  }
+}
+
+// EXECUTORS *******************************************************************
+
+/**
+ * @brief Fire-and-forget coroutine that runs a pipeline on an executor
+ *
+ */
+struct PipelineTask {
+  struct promise_type {
+    PipelineTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+/**
+ * @brief Executor that runs pipelines immediately on the calling thread
+ *
+ */
+class InlineExecutor {
+ public:
+  /**
+   * @brief Awaitable that continues on the calling thread
+   *
+   */
+  std::suspend_never schedule() noexcept { return {}; }
+  /**
+   * @brief Nothing to wait for: pipelines finish before `run_pipeline`
+   * returns
+   *
+   */
+  void wait() {}
+};
+
+/**
+ * @brief Executor that runs pipelines on a pool of worker threads
+ *
+ * `co_await pool.schedule()` moves the awaiting coroutine onto a worker, so
+ * independent pipelines run in parallel while each stays single-threaded.
+ */
+class ThreadPool {
+ public:
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Start the workers
+   *
+   * @param threads - number of worker threads (0 for one per hardware thread)
+   */
+  explicit ThreadPool(int threads = 0) {
+    if (threads <= 0) {
+      threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    for (int ii{0}; ii < threads; ++ii) {
+      _workers.emplace_back([this]() { work(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Finish the queued work and stop the workers
+   *
+   */
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _stopping = true;
+    }
+    _ready.notify_all();
+    for (auto& worker : _workers) {
+      worker.join();
+    }
+  }
+
+  // SCHEDULING ****************************************************************
+
+  /**
+   * @brief Awaitable that resumes the awaiting coroutine on a worker
+   *
+   */
+  auto schedule() {
+    struct Awaiter {
+      ThreadPool& pool;
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> handle) {
+        pool.enqueue(handle);
+      }
+      void await_resume() const noexcept {}
+    };
+    return Awaiter{*this};
+  }
+
+  /**
+   * @brief Block until every scheduled coroutine has finished or suspended
+   *
+   */
+  void wait() {
+    std::unique_lock<std::mutex> lock{_mutex};
+    _idle.wait(lock, [this]() { return _pending == 0; });
+  }
+
+ private:
+  /**
+   * @brief Queue a coroutine to be resumed by a worker
+   *
+   */
+  void enqueue(const std::coroutine_handle<> handle) {
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _queue.push_back(handle);
+      ++_pending;
+    }
+    _ready.notify_one();
+  }
+
+  /**
+   * @brief Worker loop: resume queued coroutines until stopped
+   *
+   */
+  void work() {
+    for (;;) {
+      std::coroutine_handle<> handle;
+      {
+        std::unique_lock<std::mutex> lock{_mutex};
+        _ready.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+        if (_queue.empty()) {
+          return;
+        }
+        handle = _queue.front();
+        _queue.pop_front();
+      }
+      handle.resume();
+      {
+        std::lock_guard<std::mutex> lock{_mutex};
+        --_pending;
+      }
+      _idle.notify_all();
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  std::vector<std::thread> _workers{};           ///< Worker threads
+  std::deque<std::coroutine_handle<>> _queue{};  ///< Coroutines to resume
+  std::mutex _mutex{};                           ///< Guards the queue
+  std::condition_variable _ready{};              ///< Signals queued work
+  std::condition_variable _idle{};               ///< Signals finished work
+  int _pending{0};                               ///< Queued or running
+  bool _stopping{false};                         ///< Set on destruction
+};
+
+/**
+ * @brief Run a pipeline to completion on an executor, handing every output
+ * block to a sink
+ *
+ * The task owns the stream and the sink; anything they reference (filters,
+ * source data) must stay alive until the executor's `wait()` returns.
+ * Exceptions thrown by a stage on a pool worker terminate the program, as
+ * they would in a plain std::thread.
+ *
+ * @param executor - InlineExecutor or ThreadPool
+ * @param stream - the last stage of the pipeline
+ * @param sink - callable taking each std::span<const T> block
+ */
+template <typename Executor, typename T, typename Sink>
+PipelineTask run_pipeline(Executor& executor, BlockStream<T> stream,
+                          Sink sink) {
+  co_await executor.schedule();
+  for (const std::span<const T> block : stream) {
+    sink(block);
+  }
+}
+
+#endif
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * @file precision.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Precision policies for filter coefficients and accumulators
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef FILTER_PRECISION_HPP
+#define FILTER_PRECISION_HPP
+
+/**
+ * @brief Precision policy for a filter
+ *
+ * Filters take their sample type T (what goes in and comes out of `filter`,
+ * and what is stored in windows) as their first template parameter. The
+ * policy picks the types used for everything else:
+ *
+ *  - coefficient_type: filter constants and weights
+ *  - accumulator_type: running sums and recursive state
+ *
+ * The default, Precision<T>, uses T throughout. Typical mixes are
+ *    MovingAverageFilter<float, Precision<float, double>>
+ * for float samples with a double running sum, and
+ *    ExponentialFilter<_Float16, Precision<float>>
+ * for half-precision storage with float math.
+ *
+ * @tparam Coefficient - type of the filter coefficients
+ * @tparam Accumulator - type of the filter state and sums
+ */
+template <typename Coefficient, typename Accumulator = Coefficient>
+struct Precision {
+  using coefficient_type = Coefficient;
+  using accumulator_type = Accumulator;
+};
+
+#endif
@@ -0,0 +1,553 @@
+/**
+ * @file replay.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Capture of input streams and deterministic replay through filters
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef REPLAY_FILTER_HPP
+#define REPLAY_FILTER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "filtering/filter.hpp"
+
+/**
+ * @brief Sample type stored in a capture
+ *
+ */
+enum class CaptureType : std::uint32_t { Float = 1, Double = 2 };
+
+/**
+ * @brief Capture type of a sample type T
+ *
+ */
+template <typename T>
+constexpr CaptureType capture_type() {
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>,
+                "Captures store float or double samples");
+  return std::is_same_v<T, float> ? CaptureType::Float : CaptureType::Double;
+}
+
+/**
+ * @brief Contents of a capture header
+ *
+ */
+struct CaptureInfo {
+  CaptureType type{CaptureType::Double};  ///< Sample type
+  int channels{1};                        ///< Samples per frame
+  long frames{-1};  ///< Frames, or -1 if the writer did not finish
+};
+
+// CAPTURE FORMAT **************************************************************
+
+/**
+ * @brief Layout of capture files
+ *
+ * A capture starts with a 32 byte header, in the byte order of the machine
+ * that wrote it:
+ *    char[8] magic "FLTCAP01", uint32 version, uint32 sample type,
+ *    uint32 channels, uint32 reserved, int64 frames (-1 while recording)
+ * followed by one record per frame: the time since the previous frame in
+ * nanoseconds (since the epoch of the recording clock for the first frame) as
+ * an unsigned LEB128 varint, then the raw samples of every channel. Samples
+ * are stored bit for bit, so replays see exactly what production saw; evenly
+ * spaced frames cost two or three bytes of timestamp each.
+ */
+constexpr char kCaptureMagic[8]{'F', 'L', 'T', 'C', 'A', 'P', '0', '1'};
+constexpr std::uint32_t kCaptureVersion{1};
+constexpr long kCaptureHeaderBytes{32};
+constexpr long kCaptureFramesOffset{24};  ///< Position of the frame count
+
+/**
+ * @brief Read the header of a capture file
+ *
+ * @param path - capture file
+ * @return CaptureInfo - sample type, channels and frame count
+ */
+inline CaptureInfo read_capture_info(const std::string& path) {
+  std::ifstream file{path, std::ios::binary};
+  if (!file) {
+    throw std::runtime_error("Cannot open '" + path + "'");
+  }
+  char magic[8];
+  std::uint32_t version{0}, type{0}, channels{0}, reserved{0};
+  std::int64_t frames{0};
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(&version), sizeof(version));
+  file.read(reinterpret_cast<char*>(&type), sizeof(type));
+  file.read(reinterpret_cast<char*>(&channels), sizeof(channels));
+  file.read(reinterpret_cast<char*>(&reserved), sizeof(reserved));
+  file.read(reinterpret_cast<char*>(&frames), sizeof(frames));
+  if (!file || (std::memcmp(magic, kCaptureMagic, sizeof(magic)) != 0)) {
+    throw std::runtime_error("'" + path + "' is not a capture file");
+  }
+  if (version != kCaptureVersion) {
+    throw std::runtime_error("'" + path + "' has unsupported capture version " +
+                             std::to_string(version));
+  }
+  if ((type != static_cast<std::uint32_t>(CaptureType::Float)) &&
+      (type != static_cast<std::uint32_t>(CaptureType::Double))) {
+    throw std::runtime_error("'" + path + "' has an unknown sample type");
+  }
+  if (channels < 1) {
+    throw std::runtime_error("'" + path + "' has no channels");
+  }
+  return {static_cast<CaptureType>(type), static_cast<int>(channels),
+          static_cast<long>(frames)};
+}
+
+// CAPTURE WRITER **************************************************************
+
+/**
+ * @brief Record a stream of frames to a capture file
+ *
+ * Call `write` from the production input path with each frame as it arrives.
+ * The frame count in the header is filled in by `close` (or the destructor);
+ * a capture whose writer never closed is still readable up to its last whole
+ * frame.
+ *
+ * @tparam T - sample type, float or double
+ */
+template <typename T>
+class CaptureWriter {
+ public:
+  /**
+   * @brief Create (or truncate) a capture file
+   *
+   * @param path - capture file
+   * @param channels - samples per frame
+   */
+  CaptureWriter(const std::string& path, const int channels)
+      : _path{path}, _channels{channels} {
+    if (channels < 1) {
+      throw std::domain_error("Number of channels must be positive");
+    }
+    _file.open(path, std::ios::binary | std::ios::trunc);
+    if (!_file) {
+      throw std::runtime_error("Cannot create '" + path + "'");
+    }
+    const std::uint32_t header[4]{
+        kCaptureVersion, static_cast<std::uint32_t>(capture_type<T>()),
+        static_cast<std::uint32_t>(channels), 0};
+    const std::int64_t frames{-1};
+    _file.write(kCaptureMagic, sizeof(kCaptureMagic));
+    _file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    _file.write(reinterpret_cast<const char*>(&frames), sizeof(frames));
+  }
+
+  CaptureWriter(const CaptureWriter&) = delete;
+  CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+  /**
+   * @brief Close the capture. Errors are lost here; call `close` to see them.
+   *
+   */
+  ~CaptureWriter() {
+    try {
+      close();
+    } catch (...) {
+    }
+  }
+
+  // WRITING FUNCTIONS *********************************************************
+
+  /**
+   * @brief Append a frame
+   *
+   * @param frame - one sample per channel
+   * @param timestamp - arrival time [ns], not earlier than the previous frame
+   */
+  void write(const T* frame, const std::int64_t timestamp) {
+    if ((_frames > 0) && (timestamp < _last_timestamp)) {
+      throw std::domain_error("Capture timestamps must not decrease");
+    }
+    std::uint64_t delta{static_cast<std::uint64_t>(
+        _frames > 0 ? timestamp - _last_timestamp : timestamp)};
+    char varint[10];
+    int bytes{0};
+    do {
+      varint[bytes] = static_cast<char>(delta & 0x7F);
+      delta >>= 7;
+      if (delta != 0) {
+        varint[bytes] = static_cast<char>(varint[bytes] | 0x80);
+      }
+      ++bytes;
+    } while (delta != 0);
+
+    _file.write(varint, bytes);
+    _file.write(reinterpret_cast<const char*>(frame),
+                static_cast<std::streamsize>(sizeof(T)) * _channels);
+    if (!_file) {
+      throw std::runtime_error("Write to '" + _path + "' failed");
+    }
+    _last_timestamp = timestamp;
+    ++_frames;
+  }
+
+  /**
+   * @brief Store the frame count in the header and close the file
+   *
+   */
+  void close() {
+    if (!_file.is_open()) {
+      return;
+    }
+    const std::int64_t frames{_frames};
+    _file.seekp(kCaptureFramesOffset);
+    _file.write(reinterpret_cast<const char*>(&frames), sizeof(frames));
+    _file.close();
+    if (!_file) {
+      throw std::runtime_error("Closing '" + _path + "' failed");
+    }
+  }
+
+  /**
+   * @brief Frames written so far
+   *
+   */
+  long frames() const { return _frames; }
+
+ private:
+  std::ofstream _file;              ///< Capture file
+  std::string _path;                ///< Capture file name, for errors
+  int _channels;                    ///< Samples per frame
+  long _frames{0};                  ///< Frames written
+  std::int64_t _last_timestamp{0};  ///< Timestamp of the last frame [ns]
+};
+
+// CAPTURE *********************************************************************
+
+/**
+ * @brief A capture loaded into memory, so replays measure the filters and not
+ * the disk
+ *
+ * @tparam T - sample type, float or double
+ */
+template <typename T>
+class Capture {
+ public:
+  /**
+   * @brief Construct an empty capture
+   *
+   * @param channels - samples per frame
+   */
+  explicit Capture(const int channels = 1) : _channels{channels} {
+    if (channels < 1) {
+      throw std::domain_error("Number of channels must be positive");
+    }
+  }
+
+  /**
+   * @brief Load a capture file. The sample type must match T.
+   *
+   * @param path - capture file
+   */
+  static Capture load(const std::string& path) {
+    const CaptureInfo info{read_capture_info(path)};
+    if (info.type != capture_type<T>()) {
+      throw std::runtime_error("'" + path + "' holds " +
+                               (info.type == CaptureType::Float ? "float"
+                                                                : "double") +
+                               " samples");
+    }
+    std::ifstream file{path, std::ios::binary};
+    const std::vector<char> bytes{std::istreambuf_iterator<char>{file},
+                                  std::istreambuf_iterator<char>{}};
+
+    Capture capture{info.channels};
+    const long frame_bytes{static_cast<long>(sizeof(T)) * info.channels};
+    if (info.frames > 0) {
+      capture._timestamps.reserve(info.frames);
+      capture._samples.reserve(info.frames * info.channels);
+    }
+    std::vector<T> frame(info.channels);
+    std::int64_t timestamp{0};
+    long position{kCaptureHeaderBytes};
+    const long size{static_cast<long>(bytes.size())};
+    while (position < size) {
+      std::uint64_t delta{0};
+      int shift{0};
+      bool more{true};
+      while (more && (position < size) && (shift < 64)) {
+        const auto byte{static_cast<unsigned char>(bytes[position++])};
+        delta |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        shift += 7;
+        more = (byte & 0x80) != 0;
+      }
+      if (more || (position + frame_bytes > size)) {
+        break;  // a frame cut short by a writer that did not finish
+      }
+      timestamp += static_cast<std::int64_t>(delta);
+      std::memcpy(frame.data(), bytes.data() + position, frame_bytes);
+      position += frame_bytes;
+      capture.append(frame.data(), timestamp);
+    }
+    if ((info.frames >= 0) && (capture.frames() != info.frames)) {
+      throw std::runtime_error("'" + path + "' is truncated");
+    }
+    return capture;
+  }
+
+  /**
+   * @brief Write the capture to a file
+   *
+   * @param path - capture file
+   */
+  void save(const std::string& path) const {
+    CaptureWriter<T> writer{path, _channels};
+    for (long ff{0}; ff < frames(); ++ff) {
+      writer.write(frame(ff), _timestamps[ff]);
+    }
+    writer.close();
+  }
+
+  /**
+   * @brief Append a frame
+   *
+   * @param frame - one sample per channel
+   * @param timestamp - arrival time [ns]
+   */
+  void append(const T* frame, const std::int64_t timestamp) {
+    _samples.insert(_samples.end(), frame, frame + _channels);
+    _timestamps.push_back(timestamp);
+  }
+
+  // ACCESSORS *****************************************************************
+
+  int channels() const { return _channels; }
+  long frames() const { return static_cast<long>(_timestamps.size()); }
+  /**
+   * @brief Samples of a frame, one per channel
+   *
+   */
+  const T* frame(const long ind) const {
+    return _samples.data() + ind * _channels;
+  }
+  /**
+   * @brief All samples, frame after frame
+   *
+   */
+  const std::vector<T>& samples() const { return _samples; }
+  /**
+   * @brief Arrival time of each frame [ns]
+   *
+   */
+  const std::vector<std::int64_t>& timestamps() const { return _timestamps; }
+
+ private:
+  int _channels;                            ///< Samples per frame
+  std::vector<T> _samples{};                ///< Interleaved samples
+  std::vector<std::int64_t> _timestamps{};  ///< Arrival time per frame [ns]
+};
+
+// REPLAY **********************************************************************
+
+/**
+ * @brief How fast frames are fed to the filters
+ *
+ * MaxSpeed: back to back, to measure throughput.
+ * RealTime: each frame at its recorded time (scaled by the replay speed), to
+ *           measure how far processing falls behind the live stream.
+ */
+enum class Pacing { MaxSpeed, RealTime };
+
+/**
+ * @brief Options for replaying a capture
+ *
+ */
+struct ReplayOptions {
+  Pacing pacing{Pacing::MaxSpeed};  ///< Frame timing
+  double speed{1};                  ///< Time compression of RealTime pacing
+  int repeats{1};  ///< Replays, each with fresh filters; the fastest counts
+};
+
+/**
+ * @brief Outputs and timing of a replay
+ *
+ */
+template <typename T>
+struct ReplayResult {
+  std::vector<T> outputs{};  ///< Filtered samples, frame after frame
+  long frames{0};            ///< Frames replayed
+  int channels{0};           ///< Samples per frame
+  double seconds{0};         ///< Time spent filtering (fastest repeat) [s]
+  double max_lateness{0};  ///< Worst delay of an output past its frame's time
+                           ///< under RealTime pacing [s]
+
+  /**
+   * @brief Samples filtered per second
+   *
+   */
+  double samples_per_second() const {
+    return seconds > 0 ? static_cast<double>(frames) * channels / seconds : 0;
+  }
+};
+
+/**
+ * @brief Replay a capture through a filter, one frame at a time as in
+ * production
+ *
+ * Every channel gets its own clone of `prototype`, fed with `filter` in
+ * arrival order, so the outputs only depend on the capture and the filter
+ * configuration and can be compared bit for bit across library versions.
+ *
+ * @tparam T - sample type
+ * @param capture - recorded input stream
+ * @param prototype - filter (or FilterChain) applied to each channel
+ * @param options - pacing and repeats
+ * @return ReplayResult<T> - outputs of the last repeat and timing
+ */
+template <typename T>
+ReplayResult<T> replay(const Capture<T>& capture, const Filter<T>& prototype,
+                       const ReplayOptions& options = {}) {
+  if ((options.pacing == Pacing::RealTime) && !(options.speed > 0)) {
+    throw std::domain_error("Replay speed must be positive");
+  }
+  using Clock = std::chrono::steady_clock;
+  const int channels{capture.channels()};
+  const long frames{capture.frames()};
+
+  ReplayResult<T> result;
+  result.frames = frames;
+  result.channels = channels;
+  result.outputs.resize(capture.samples().size());
+  result.seconds = std::numeric_limits<double>::infinity();
+
+  for (int rr{0}; rr < std::max(1, options.repeats); ++rr) {
+    std::vector<std::unique_ptr<Filter<T>>> filters(channels);
+    for (auto& filter : filters) {
+      filter = prototype.clone();
+    }
+    const T* data_in{capture.samples().data()};
+    T* data_out{result.outputs.data()};
+    double lateness{0};
+
+    const auto start{Clock::now()};
+    for (long ff{0}; ff < frames; ++ff) {
+      Clock::time_point scheduled;
+      if (options.pacing == Pacing::RealTime) {
+        const double offset{
+            static_cast<double>(capture.timestamps()[ff] -
+                                capture.timestamps()[0]) /
+            options.speed};
+        scheduled = start + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double, std::nano>(
+                                    offset));
+        std::this_thread::sleep_until(scheduled);
+      }
+      const long offset{ff * channels};
+      for (int cc{0}; cc < channels; ++cc) {
+        filters[cc]->filter(data_in[offset + cc], data_out[offset + cc]);
+      }
+      if (options.pacing == Pacing::RealTime) {
+        lateness = std::max(
+            lateness,
+            std::chrono::duration<double>(Clock::now() - scheduled).count());
+      }
+    }
+    const auto stop{Clock::now()};
+
+    result.seconds = std::min(
+        result.seconds, std::chrono::duration<double>(stop - start).count());
+    result.max_lateness = std::max(result.max_lateness, lateness);
+  }
+  return result;
+}
+
+// GOLDEN OUTPUTS **************************************************************
+
+/**
+ * @brief Outcome of comparing replay outputs with golden outputs
+ *
+ */
+struct GoldenComparison {
+  long mismatches{0};        ///< Samples that differ in any bit
+  long first_frame{-1};      ///< Frame of the first mismatch, or -1
+  int first_channel{-1};     ///< Channel of the first mismatch, or -1
+  double max_error{0};       ///< Largest difference of finite samples
+  bool shape_matches{true};  ///< Same channel and frame counts
+
+  /**
+   * @brief Are the outputs bit-exact?
+   *
+   */
+  bool identical() const { return shape_matches && (mismatches == 0); }
+};
+
+/**
+ * @brief Save replay outputs as golden outputs, with the capture's timestamps
+ *
+ * @param path - golden capture file
+ * @param capture - replayed capture
+ * @param result - replay of `capture`
+ */
+template <typename T>
+void save_golden(const std::string& path, const Capture<T>& capture,
+                 const ReplayResult<T>& result) {
+  CaptureWriter<T> writer{path, result.channels};
+  for (long ff{0}; ff < result.frames; ++ff) {
+    writer.write(result.outputs.data() + ff * result.channels,
+                 capture.timestamps()[ff]);
+  }
+  writer.close();
+}
+
+/**
+ * @brief Compare replay outputs with golden outputs bit for bit
+ *
+ * Samples are compared by their bytes, so NaN outputs match NaN outputs with
+ * the same payload and +0 does not match -0. The largest absolute difference
+ * is reported to tell rounding changes from real regressions.
+ *
+ * @param result - replay outputs
+ * @param golden - golden outputs, e.g. from `save_golden` on a reference
+ * version
+ */
+template <typename T>
+GoldenComparison compare_golden(const ReplayResult<T>& result,
+                                const Capture<T>& golden) {
+  GoldenComparison comparison;
+  if ((result.channels != golden.channels()) ||
+      (result.frames != golden.frames())) {
+    comparison.shape_matches = false;
+    return comparison;
+  }
+  const long size{static_cast<long>(result.outputs.size())};
+  for (long ii{0}; ii < size; ++ii) {
+    const T output{result.outputs[ii]};
+    const T expected{golden.samples()[ii]};
+    if (std::memcmp(&output, &expected, sizeof(T)) == 0) {
+      continue;
+    }
+    if (comparison.mismatches == 0) {
+      comparison.first_frame = ii / result.channels;
+      comparison.first_channel = static_cast<int>(ii % result.channels);
+    }
+    ++comparison.mismatches;
+    if (std::isfinite(output) && std::isfinite(expected)) {
+      comparison.max_error =
+          std::max(comparison.max_error,
+                   static_cast<double>(std::abs(output - expected)));
+    }
+  }
+  return comparison;
+}
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file ringbuffer.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Circular data buffer shared by the windowed filters
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * @brief Fixed-size circular buffer holding the most recent data points
+ *
+ * Pushing a new point overwrites (and returns) the oldest point. The storage
+ * is a single contiguous vector, so the window can be walked as at most two
+ * contiguous segments: [head, size) holds the oldest points and [0, head) the
+ * newest ones.
+ *
+ * @tparam T - data type stored in the buffer
+ */
+template <typename T>
+class RingBuffer {
+ public:
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct an empty Ring Buffer object
+   *
+   */
+  RingBuffer() = default;
+
+  /**
+   * @brief Construct a new Ring Buffer object filled with zeros
+   *
+   * @param size - number of data points held in the buffer
+   */
+  RingBuffer(const int size) { resize(size); }
+
+  // BUFFER FUNCTIONS **********************************************************
+
+  /**
+   * @brief Push a new data point into the buffer, evicting the oldest one
+   *
+   * @param data_in - newest data point
+   * @return T - the data point that was evicted
+   */
+  inline T push(const T data_in) {
+    const T oldest{_data[_head]};
+    _data[_head] = data_in;
+    if (++_head == size()) {
+      _head = 0;
+    }
+    return oldest;
+  }
+
+  /**
+   * @brief Access a stored data point by its age
+   *
+   * @param age - 0 for the newest data point, size()-1 for the oldest
+   * @return T - the stored data point
+   */
+  inline T operator[](const int age) const {
+    const int ind{_head - 1 - age};
+    return _data[ind < 0 ? ind + size() : ind];
+  }
+
+  /**
+   * @brief Set every stored data point to a value, keeping the head in place
+   *
+   * @param value - value to fill the buffer with
+   */
+  void fill(const T value) { std::fill(_data.begin(), _data.end(), value); }
+
+  /**
+   * @brief Reset the buffer by setting all the data points to zero.
+   *
+   */
+  void reset() {
+    fill(0);
+    _head = 0;
+  }
+
+  /**
+   * @brief Change the number of points held. Note that this resets the buffer.
+   *
+   * @param size - new number of data points
+   */
+  void resize(const int size) {
+    _data.resize(size);
+    reset();
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Number of data points held in the buffer
+   *
+   */
+  inline int size() const { return static_cast<int>(_data.size()); }
+  /**
+   * @brief Index of the oldest data point (and of the next write)
+   *
+   */
+  inline int head() const { return _head; }
+  /**
+   * @brief Raw pointer to the underlying storage, for segment-wise loops
+   *
+   */
+  inline const T* data() const { return _data.data(); }
+
+ private:
+  // VARIABLES *****************************************************************
+
+  std::vector<T> _data{};  ///< Internal data vector
+  int _head{0};            ///< Index at which the next point is entered
+};
+
+#endif
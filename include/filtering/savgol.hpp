@@ -0,0 +1,350 @@
+/**
+ * @file savgol.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Savitzky-Golay smoothing and derivative filters
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef SAVGOL_FILTER_HPP
+#define SAVGOL_FILTER_HPP
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "filtering/fir.hpp"
+
+// COEFFICIENT DESIGN **********************************************************
+
+/**
+ * @brief Highest polynomial order supported by the Savitzky-Golay design
+ *
+ */
+constexpr int kSavitzkyGolayMaxOrder{10};
+
+/**
+ * @brief Compute Savitzky-Golay convolution weights
+ *
+ * A polynomial of degree `order` is least-squares fitted to a window of
+ * 2*half_window+1 points, and the `derivative`-th derivative of that
+ * polynomial is evaluated at the window centre. The resulting weights are
+ * written oldest-first, i.e. weights[0] multiplies the oldest point.
+ *
+ * The function is constexpr so that fixed designs can be generated at compile
+ * time (see `savitzky_golay_coefficients`), and is also what the runtime
+ * filters use at construction.
+ *
+ * @tparam T - data type of the weights
+ * @param weights - output, must hold 2*half_window+1 values
+ * @param half_window - number of points on either side of the centre
+ * @param order - degree of the fitted polynomial
+ * @param derivative - 0 for smoothing, 1 for velocity, 2 for acceleration
+ * @param dt - the sampling interval
+ */
+template <typename T>
+constexpr void savitzky_golay_weights(T* weights, const int half_window,
+                                      const int order, const int derivative,
+                                      const T dt) {
+  if (half_window < 1) {
+    throw std::domain_error("Savitzky-Golay window size must be odd and >= 3");
+  }
+  if ((order < 0) || (order > kSavitzkyGolayMaxOrder) ||
+      (order >= 2 * half_window + 1)) {
+    throw std::domain_error(
+        "Savitzky-Golay order must be in the range [0, window size)");
+  }
+  if ((derivative < 0) || (derivative > order)) {
+    throw std::domain_error(
+        "Savitzky-Golay derivative must be in the range [0, order]");
+  }
+
+  // Normal equations G*x = e_d with G_jk = sum_u u^(j+k), using the scaled
+  // abscissa u = t/half_window to keep G well conditioned.
+  constexpr int kMax{kSavitzkyGolayMaxOrder + 1};
+  T system[kMax][kMax + 1]{};
+  const int dim{order + 1};
+
+  for (int tt{-half_window}; tt <= half_window; ++tt) {
+    const T u{static_cast<T>(tt) / half_window};
+    T u_pow{1};
+    T powers[2 * kMax]{};
+    for (int kk{0}; kk < 2 * dim - 1; ++kk) {
+      powers[kk] = u_pow;
+      u_pow *= u;
+    }
+    for (int jj{0}; jj < dim; ++jj) {
+      for (int kk{0}; kk < dim; ++kk) {
+        system[jj][kk] += powers[jj + kk];
+      }
+    }
+  }
+  system[derivative][dim] = 1;
+
+  // Gauss-Jordan elimination with partial pivoting
+  for (int col{0}; col < dim; ++col) {
+    int pivot{col};
+    for (int row{col + 1}; row < dim; ++row) {
+      const T candidate{system[row][col] < 0 ? -system[row][col]
+                                             : system[row][col]};
+      const T best{system[pivot][col] < 0 ? -system[pivot][col]
+                                          : system[pivot][col]};
+      if (candidate > best) {
+        pivot = row;
+      }
+    }
+    for (int kk{0}; kk <= dim; ++kk) {
+      const T tmp{system[col][kk]};
+      system[col][kk] = system[pivot][kk];
+      system[pivot][kk] = tmp;
+    }
+    for (int row{0}; row < dim; ++row) {
+      if (row == col) {
+        continue;
+      }
+      const T factor{system[row][col] / system[col][col]};
+      for (int kk{col}; kk <= dim; ++kk) {
+        system[row][kk] -= factor * system[col][kk];
+      }
+    }
+  }
+
+  // d! / (half_window*dt)^d undoes the abscissa scaling
+  T scale{1};
+  for (int dd{1}; dd <= derivative; ++dd) {
+    scale *= static_cast<T>(dd) / (half_window * dt);
+  }
+
+  for (int tt{-half_window}; tt <= half_window; ++tt) {
+    const T u{static_cast<T>(tt) / half_window};
+    T u_pow{1};
+    T weight{0};
+    for (int kk{0}; kk < dim; ++kk) {
+      weight += system[kk][dim] / system[kk][kk] * u_pow;
+      u_pow *= u;
+    }
+    weights[tt + half_window] = scale * weight;
+  }
+}
+
+/**
+ * @brief Compile-time Savitzky-Golay weights for a fixed window and order
+ *
+ * e.g. `constexpr auto w = savitzky_golay_coefficients<double, 7, 2, 1>();`
+ * An invalid design fails to compile.
+ *
+ * @tparam T - data type of the weights
+ * @tparam Window - number of points in the window (odd)
+ * @tparam Order - degree of the fitted polynomial
+ * @tparam Derivative - derivative to evaluate (0 for smoothing)
+ * @param dt - the sampling interval
+ * @return std::array<T, Window> - weights, oldest point first
+ */
+template <typename T, int Window, int Order, int Derivative = 0>
+constexpr std::array<T, Window> savitzky_golay_coefficients(const T dt = 1) {
+  static_assert(Window % 2 == 1, "Savitzky-Golay window size must be odd");
+  static_assert(Order < Window, "Savitzky-Golay order must be < window size");
+  static_assert(Derivative <= Order,
+                "Savitzky-Golay derivative must be <= order");
+
+  std::array<T, Window> weights{};
+  savitzky_golay_weights(&weights[0], Window / 2, Order, Derivative, dt);
+  return weights;
+}
+
+/**
+ * @brief Runtime Savitzky-Golay weights for a window size
+ *
+ * @tparam T - data type of the weights
+ * @param window_size - number of points in the window (odd, >= 3)
+ * @param order - degree of the fitted polynomial
+ * @param derivative - derivative to evaluate (0 for smoothing)
+ * @param dt - the sampling interval
+ * @return std::vector<T> - weights, oldest point first
+ */
+template <typename T>
+std::vector<T> savitzky_golay_design(const int window_size, const int order,
+                                     const int derivative, const T dt) {
+  if ((window_size < 3) || (window_size % 2 == 0)) {
+    throw std::domain_error("Savitzky-Golay window size must be odd and >= 3");
+  }
+  std::vector<T> weights(window_size);
+  savitzky_golay_weights(weights.data(), window_size / 2, order, derivative,
+                         dt);
+  return weights;
+}
+
+// SAVITZKY-GOLAY FILTER *******************************************************
+
+/**
+ * @brief Savitzky-Golay filter
+ *
+ * Fits a polynomial to the last `window_size` points and outputs its value (or
+ * one of its derivatives) at the centre of the window. The output is therefore
+ * delayed by `group_delay()` = (window_size-1)/2 samples. This is a FIRFilter
+ * whose taps are redesigned whenever the window size changes.
+ *
+ * @tparam T - data type used by the filter
+ */
+template <typename T>
+class SavitzkyGolayFilter : public FIRFilter<T> {
+ public:
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new Savitzky-Golay Filter object
+   *
+   * @param window_size - number of points in the window (odd)
+   * @param order - degree of the fitted polynomial
+   * @param derivative - 0 for smoothing, 1 for first derivative, etc.
+   * @param dt - the sampling interval, used to scale derivatives
+   */
+  SavitzkyGolayFilter(const int window_size, const int order,
+                      const int derivative = 0, const T dt = 1)
+      : FIRFilter<T>{savitzky_golay_design(window_size, order, derivative, dt)},
+        _order{order},
+        _derivative{derivative},
+        _dt{dt} {}
+
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Set the window size. Note that this recomputes the weights and
+   * resets the filter.
+   *
+   * @param size - number of points in the window (odd)
+   */
+  virtual void set_filter_size(const int size) override {
+    this->set_taps(savitzky_golay_design(size, _order, _derivative, _dt));
+  }
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<SavitzkyGolayFilter<T>>(*this);
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Delay between an input sample and the output describing it
+   *
+   * @return int - group delay in samples
+   */
+  int group_delay() const {
+    return static_cast<int>(this->taps().size()) / 2;
+  }
+
+ private:
+  // VARIABLES *****************************************************************
+
+  int _order;       ///< Degree of the fitted polynomial
+  int _derivative;  ///< Derivative evaluated at the window centre
+  T _dt;            ///< Sampling interval
+};
+
+// MULTI-CHANNEL BANK **********************************************************
+
+/**
+ * @brief Savitzky-Golay filter applied to N streams with a shared design
+ *
+ * Unlike a MultiStreamFilter of SavitzkyGolayFilters, the bank stores its
+ * window as a ring of frames, so the inner loop runs across channels over
+ * contiguous memory and vectorizes.
+ *
+ * @tparam T - type of each incoming data stream
+ * @tparam N - number of data streams
+ */
+template <typename T, int N>
+class SavitzkyGolayBank {
+ public:
+  // CONSTRUCTOR ***************************************************************
+
+  /**
+   * @brief Construct a new Savitzky-Golay Bank object
+   *
+   * @param window_size - number of points in the window (odd)
+   * @param order - degree of the fitted polynomial
+   * @param derivative - 0 for smoothing, 1 for first derivative, etc.
+   * @param dt - the sampling interval, used to scale derivatives
+   */
+  SavitzkyGolayBank(const int window_size, const int order,
+                    const int derivative = 0, const T dt = 1)
+      : _order{order}, _derivative{derivative}, _dt{dt} {
+    set_filter_size(window_size);
+  }
+
+  // FILTER FUNCTIONS **********************************************************
+
+  /**
+   * @brief Filter one frame of data, one point per stream
+   *
+   * @param data_in - newest point of every stream
+   * @param data_out - filtered output of every stream
+   */
+  void filter(const std::array<T, N>& data_in, std::array<T, N>& data_out) {
+    const int window{static_cast<int>(_weights.size())};
+    _frames[_head] = data_in;
+    if (++_head == window) {
+      _head = 0;
+    }
+
+    std::array<T, N> sum{};
+    for (int ii{0}; ii < window; ++ii) {
+      const int ind{_head + ii < window ? _head + ii : _head + ii - window};
+      const T weight{_weights[ii]};
+      const std::array<T, N>& frame{_frames[ind]};
+      for (int cc{0}; cc < N; ++cc) {
+        sum[cc] += weight * frame[cc];
+      }
+    }
+    data_out = sum;
+  }
+
+  /**
+   * @brief Reset the filters
+   *
+   */
+  void reset() {
+    std::fill(_frames.begin(), _frames.end(), std::array<T, N>{});
+    _head = 0;
+  }
+
+  /**
+   * @brief Set the window size. Note that this resets the bank.
+   *
+   * @param size - number of points in the window (odd)
+   */
+  void set_filter_size(const int size) {
+    _weights = savitzky_golay_design(size, _order, _derivative, _dt);
+    _frames.resize(size);
+    reset();
+  }
+
+  /**
+   * @brief Delay between an input frame and the output describing it
+   *
+   * @return int - group delay in samples
+   */
+  int group_delay() const { return static_cast<int>(_weights.size()) / 2; }
+
+ private:
+  // VARIABLES *****************************************************************
+
+  std::vector<std::array<T, N>> _frames{};  ///< Ring of the last frames
+  std::vector<T> _weights{};  ///< Convolution weights, oldest frame first
+  int _head{0};               ///< Index at which the next frame is entered
+
+  int _order;       ///< Degree of the fitted polynomial
+  int _derivative;  ///< Derivative evaluated at the window centre
+  T _dt;            ///< Sampling interval
+};
+
+#endif
@@ -0,0 +1,514 @@
+/**
+ * @file spectral.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Tone-detection filters tracking a few DFT bins of a data stream
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef SPECTRAL_FILTER_HPP
+#define SPECTRAL_FILTER_HPP
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "filtering/filter.hpp"
+#include "filtering/ringbuffer.hpp"
+
+/**
+ * @brief Nearest DFT bin to a frequency for a given window
+ *
+ * @tparam T - data type of the frequencies
+ * @param frequency - tone frequency [Hz]
+ * @param sample_rate - frequency at which new data arrives [Hz]
+ * @param window_size - number of points in the DFT window
+ * @return int - bin index
+ */
+template <typename T>
+int dft_bin(const T frequency, const T sample_rate, const int window_size) {
+  return static_cast<int>(std::lround(frequency * window_size / sample_rate));
+}
+
+// SLIDING DFT FILTER **********************************************************
+
+/**
+ * @brief Sliding DFT filter
+ *
+ * Tracks K chosen bins of the DFT of the last `window_size` points in O(K) per
+ * sample, using the recurrence
+ *    X_k[n] = e^(j*2*pi*k/N) * (X_k[n-1] - x[n-N] + x[n])
+ * on the same circular buffer as the MovingAverageFilter. To stop rounding
+ * errors accumulating, the bins are recomputed exactly from the buffer once
+ * per window, which keeps the amortized cost at O(K) per sample.
+ *
+ * The filter output is the amplitude of the first requested bin; every bin is
+ * available through `amplitude`, `phase` and `bin`.
+ *
+ * @tparam T - data type used by the filter
+ */
+template <typename T>
+class SlidingDFTFilter : public Filter<T> {
+ public:
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new Sliding DFT Filter object
+   *
+   * @param window_size - number of points in the DFT window
+   * @param bins - DFT bin indices to track, each in [0, window_size)
+   */
+  SlidingDFTFilter(const int window_size, const std::vector<int>& bins)
+      : _bins{bins} {
+    if (_bins.empty()) {
+      throw std::domain_error("Sliding DFT needs at least one bin");
+    }
+    set_filter_size(window_size);
+  }
+
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Apply the filter to a new input data point
+   *
+   * @param data_in - newest arrived data point
+   * @param data_out - reference to the amplitude of the first bin
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    const T delta{data_in - _data.push(data_in)};
+
+    if (_data.head() == 0) {
+      resync();
+    } else {
+      for (std::size_t kk{0}; kk < _spectrum.size(); ++kk) {
+        _spectrum[kk] = _twiddles[kk] * (_spectrum[kk] + delta);
+      }
+    }
+    data_out = amplitude(0);
+  }
+
+  /**
+   * @brief Reset the filter by resetting all the data points to zero.
+   *
+   */
+  virtual void reset() override {
+    _data.reset();
+    std::fill(_spectrum.begin(), _spectrum.end(), std::complex<T>{0});
+  }
+  /**
+   * @brief Fill the window with a constant input
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override {
+    _data.fill(value);
+    resync();
+  }
+
+  /**
+   * @brief Set the window size. Note that this resets the filter.
+   *
+   * @param size - number of points in the DFT window
+   */
+  virtual void set_filter_size(const int size) override {
+    for (const int bin : _bins) {
+      if ((bin < 0) || (bin >= size)) {
+        throw std::domain_error("DFT bins must be in the range [0, size)");
+      }
+    }
+    _twiddles.resize(_bins.size());
+    for (std::size_t kk{0}; kk < _bins.size(); ++kk) {
+      const T omega{static_cast<T>(2 * M_PI * _bins[kk] / size)};
+      _twiddles[kk] = std::polar(T{1}, omega);
+    }
+    _spectrum.resize(_bins.size());
+    _data.resize(size);
+    reset();
+  }
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<SlidingDFTFilter<T>>(*this);
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Complex DFT value of a tracked bin, oldest point at time zero
+   *
+   * @param ind - index into the bins passed at construction
+   */
+  std::complex<T> bin(const int ind) const { return _spectrum[ind]; }
+  /**
+   * @brief Amplitude of the tone in a tracked bin, i.e. 2|X_k|/N
+   *
+   * @param ind - index into the bins passed at construction
+   */
+  T amplitude(const int ind) const {
+    return 2 * std::abs(_spectrum[ind]) / _data.size();
+  }
+  /**
+   * @brief Phase of a tracked bin [rad]
+   *
+   * @param ind - index into the bins passed at construction
+   */
+  T phase(const int ind) const { return std::arg(_spectrum[ind]); }
+
+ private:
+  // PRIVATE SUPPORT FUNCTIONS *************************************************
+
+  /**
+   * @brief Recompute every tracked bin exactly from the circular buffer
+   *
+   */
+  void resync() {
+    for (std::size_t kk{0}; kk < _bins.size(); ++kk) {
+      const std::complex<T> step{std::conj(_twiddles[kk])};
+      std::complex<T> rotation{1};
+      std::complex<T> sum{0};
+      for (int age{_data.size() - 1}; age >= 0; --age) {
+        sum += _data[age] * rotation;
+        rotation *= step;
+      }
+      _spectrum[kk] = sum;
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  RingBuffer<T> _data{};                     ///< Internal circular data buffer
+  std::vector<int> _bins;                    ///< Tracked DFT bin indices
+  std::vector<std::complex<T>> _twiddles{};  ///< e^(j*2*pi*k/N) per bin
+  std::vector<std::complex<T>> _spectrum{};  ///< Current value of each bin
+};
+
+// GOERTZEL FILTER *************************************************************
+
+/**
+ * @brief Goertzel filter
+ *
+ * Evaluates the DFT at K arbitrary frequencies over consecutive,
+ * non-overlapping blocks of `block_size` points. Each sample costs one
+ * multiply-add per frequency; the amplitude and phase are updated at the end of
+ * every block and held in between. Use the SlidingDFTFilter when an update is
+ * needed on every sample.
+ *
+ * The filter output is the amplitude of the first requested frequency.
+ *
+ * @tparam T - data type used by the filter
+ */
+template <typename T>
+class GoertzelFilter : public Filter<T> {
+ public:
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new Goertzel Filter object
+   *
+   * @param block_size - number of points per evaluated block
+   * @param frequencies - tone frequencies to evaluate [Hz]
+   * @param sample_rate - frequency at which new data arrives [Hz]
+   */
+  GoertzelFilter(const int block_size, const std::vector<T>& frequencies,
+                 const T sample_rate)
+      : _frequencies{frequencies}, _sample_rate{sample_rate} {
+    if (_frequencies.empty()) {
+      throw std::domain_error("Goertzel filter needs at least one frequency");
+    }
+    set_filter_size(block_size);
+  }
+
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Apply the filter to a new input data point
+   *
+   * @param data_in - newest arrived data point
+   * @param data_out - reference to the amplitude of the first frequency
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    for (std::size_t kk{0}; kk < _coefficients.size(); ++kk) {
+      const T s0{data_in + _coefficients[kk] * _s1[kk] - _s2[kk]};
+      _s2[kk] = _s1[kk];
+      _s1[kk] = s0;
+    }
+
+    if (++_count == _block_size) {
+      for (std::size_t kk{0}; kk < _coefficients.size(); ++kk) {
+        _result[kk] =
+            _alignment[kk] * (_s1[kk] - std::conj(_rotation[kk]) * _s2[kk]);
+      }
+      std::fill(_s1.begin(), _s1.end(), 0);
+      std::fill(_s2.begin(), _s2.end(), 0);
+      _count = 0;
+    }
+    data_out = amplitude(0);
+  }
+
+  /**
+   * @brief Reset the filter by discarding the current block and results.
+   *
+   */
+  virtual void reset() override {
+    std::fill(_s1.begin(), _s1.end(), 0);
+    std::fill(_s2.begin(), _s2.end(), 0);
+    std::fill(_result.begin(), _result.end(), std::complex<T>{0});
+    _count = 0;
+  }
+
+  /**
+   * @brief Set the block size. Note that this resets the filter.
+   *
+   * @param size - number of points per evaluated block
+   */
+  virtual void set_filter_size(const int size) override {
+    if (size < 1) {
+      throw std::domain_error("Goertzel block size must be positive");
+    }
+    _block_size = size;
+
+    const std::size_t count{_frequencies.size()};
+    _coefficients.resize(count);
+    _rotation.resize(count);
+    _alignment.resize(count);
+    for (std::size_t kk{0}; kk < count; ++kk) {
+      const T omega{static_cast<T>(2 * M_PI) * _frequencies[kk] / _sample_rate};
+      _coefficients[kk] = 2 * std::cos(omega);
+      _rotation[kk] = std::polar(T{1}, omega);
+      _alignment[kk] = std::polar(T{1}, -omega * (size - 1));
+    }
+    _s1.resize(count);
+    _s2.resize(count);
+    _result.resize(count);
+    reset();
+  }
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<GoertzelFilter<T>>(*this);
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Complex DFT value of the last complete block at a frequency
+   *
+   * @param ind - index into the frequencies passed at construction
+   */
+  std::complex<T> bin(const int ind) const { return _result[ind]; }
+  /**
+   * @brief Amplitude of the tone at a frequency, i.e. 2|X|/N
+   *
+   * @param ind - index into the frequencies passed at construction
+   */
+  T amplitude(const int ind) const {
+    return 2 * std::abs(_result[ind]) / _block_size;
+  }
+  /**
+   * @brief Phase at a frequency, relative to the start of the block [rad]
+   *
+   * @param ind - index into the frequencies passed at construction
+   */
+  T phase(const int ind) const { return std::arg(_result[ind]); }
+
+ private:
+  // VARIABLES *****************************************************************
+
+  std::vector<T> _frequencies;  ///< Evaluated frequencies [Hz]
+  T _sample_rate;               ///< Sample rate [Hz]
+  int _block_size{};            ///< Points per evaluated block
+  int _count{0};                ///< Points seen in the current block
+
+  std::vector<T> _coefficients{};             ///< 2*cos(w) per frequency
+  std::vector<std::complex<T>> _rotation{};   ///< e^(jw) per frequency
+  std::vector<std::complex<T>> _alignment{};  ///< e^(-jw(N-1)) per frequency
+  std::vector<T> _s1{};                       ///< s[n-1] per frequency
+  std::vector<T> _s2{};                       ///< s[n-2] per frequency
+  std::vector<std::complex<T>> _result{};     ///< Last block's DFT values
+};
+
+// MULTI-CHANNEL BANK **********************************************************
+
+/**
+ * @brief Sliding DFT applied to N streams with shared bins
+ *
+ * Stores the window as a ring of frames and the bins as split real/imaginary
+ * arrays, so every update runs across channels over contiguous memory and
+ * vectorizes. Resynchronizes once per window like the SlidingDFTFilter.
+ *
+ * @tparam T - type of each incoming data stream
+ * @tparam N - number of data streams
+ */
+template <typename T, int N>
+class SlidingDFTBank {
+ public:
+  // CONSTRUCTOR ***************************************************************
+
+  /**
+   * @brief Construct a new Sliding DFT Bank object
+   *
+   * @param window_size - number of points in the DFT window
+   * @param bins - DFT bin indices to track, each in [0, window_size)
+   */
+  SlidingDFTBank(const int window_size, const std::vector<int>& bins)
+      : _bins{bins} {
+    if (_bins.empty()) {
+      throw std::domain_error("Sliding DFT needs at least one bin");
+    }
+    set_filter_size(window_size);
+  }
+
+  // FILTER FUNCTIONS **********************************************************
+
+  /**
+   * @brief Filter one frame of data, one point per stream
+   *
+   * @param data_in - newest point of every stream
+   * @param data_out - amplitude of the first bin for every stream
+   */
+  void filter(const std::array<T, N>& data_in, std::array<T, N>& data_out) {
+    std::array<T, N> delta;
+    std::array<T, N>& oldest{_frames[_head]};
+    for (int cc{0}; cc < N; ++cc) {
+      delta[cc] = data_in[cc] - oldest[cc];
+    }
+    oldest = data_in;
+
+    if (++_head == window_size()) {
+      _head = 0;
+      resync();
+    } else {
+      for (std::size_t kk{0}; kk < _bins.size(); ++kk) {
+        const T cos_k{_cos[kk]};
+        const T sin_k{_sin[kk]};
+        std::array<T, N>& re{_real[kk]};
+        std::array<T, N>& im{_imag[kk]};
+        for (int cc{0}; cc < N; ++cc) {
+          const T a{re[cc] + delta[cc]};
+          const T b{im[cc]};
+          re[cc] = a * cos_k - b * sin_k;
+          im[cc] = a * sin_k + b * cos_k;
+        }
+      }
+    }
+
+    for (int cc{0}; cc < N; ++cc) {
+      data_out[cc] = amplitude(0, cc);
+    }
+  }
+
+  /**
+   * @brief Reset the filters
+   *
+   */
+  void reset() {
+    std::fill(_frames.begin(), _frames.end(), std::array<T, N>{});
+    std::fill(_real.begin(), _real.end(), std::array<T, N>{});
+    std::fill(_imag.begin(), _imag.end(), std::array<T, N>{});
+    _head = 0;
+  }
+
+  /**
+   * @brief Set the window size. Note that this resets the bank.
+   *
+   * @param size - number of points in the DFT window
+   */
+  void set_filter_size(const int size) {
+    for (const int bin : _bins) {
+      if ((bin < 0) || (bin >= size)) {
+        throw std::domain_error("DFT bins must be in the range [0, size)");
+      }
+    }
+    _cos.resize(_bins.size());
+    _sin.resize(_bins.size());
+    for (std::size_t kk{0}; kk < _bins.size(); ++kk) {
+      const T omega{static_cast<T>(2 * M_PI * _bins[kk] / size)};
+      _cos[kk] = std::cos(omega);
+      _sin[kk] = std::sin(omega);
+    }
+    _real.resize(_bins.size());
+    _imag.resize(_bins.size());
+    _frames.resize(size);
+    reset();
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Amplitude of the tone in a tracked bin of one stream
+   *
+   * @param ind - index into the bins passed at construction
+   * @param channel - stream index
+   */
+  T amplitude(const int ind, const int channel) const {
+    return 2 * std::hypot(_real[ind][channel], _imag[ind][channel]) /
+           window_size();
+  }
+  /**
+   * @brief Phase of a tracked bin of one stream [rad]
+   *
+   * @param ind - index into the bins passed at construction
+   * @param channel - stream index
+   */
+  T phase(const int ind, const int channel) const {
+    return std::atan2(_imag[ind][channel], _real[ind][channel]);
+  }
+  /**
+   * @brief Number of points in the DFT window
+   *
+   */
+  int window_size() const { return static_cast<int>(_frames.size()); }
+
+ private:
+  // PRIVATE SUPPORT FUNCTIONS *************************************************
+
+  /**
+   * @brief Recompute every tracked bin exactly from the ring of frames. Only
+   * called when the head has wrapped, so frame 0 is the oldest.
+   *
+   */
+  void resync() {
+    for (std::size_t kk{0}; kk < _bins.size(); ++kk) {
+      std::array<T, N> re{};
+      std::array<T, N> im{};
+      for (int mm{0}; mm < window_size(); ++mm) {
+        const T omega{
+            static_cast<T>(2 * M_PI * _bins[kk] * mm / window_size())};
+        const T cos_m{std::cos(omega)};
+        const T sin_m{-std::sin(omega)};
+        for (int cc{0}; cc < N; ++cc) {
+          re[cc] += _frames[mm][cc] * cos_m;
+          im[cc] += _frames[mm][cc] * sin_m;
+        }
+      }
+      _real[kk] = re;
+      _imag[kk] = im;
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  std::vector<std::array<T, N>> _frames{};  ///< Ring of the last frames
+  int _head{0};  ///< Index at which the next frame is entered
+
+  std::vector<int> _bins;                 ///< Tracked DFT bin indices
+  std::vector<T> _cos{};                  ///< cos(2*pi*k/N) per bin
+  std::vector<T> _sin{};                  ///< sin(2*pi*k/N) per bin
+  std::vector<std::array<T, N>> _real{};  ///< Real part per bin and stream
+  std::vector<std::array<T, N>> _imag{};  ///< Imaginary part per bin and stream
+};
+
+#endif
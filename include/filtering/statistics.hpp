@@ -0,0 +1,669 @@
+/**
+ * @file statistics.hpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Running statistics (mean, variance, z-score) of data streams
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef STATISTICS_FILTER_HPP
+#define STATISTICS_FILTER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include "filtering/filter.hpp"
+#include "filtering/gaps.hpp"
+#include "filtering/multistream.hpp"
+
+/**
+ * @brief Which running statistic a statistics filter outputs
+ *
+ * ZScore is the distance of the newest sample from the mean in standard
+ * deviations, measured against the statistics *before* the sample is added,
+ * so an outlier does not hide itself. It is zero while the variance is zero.
+ * Skewness and (excess) Kurtosis are only available from windowed filters.
+ */
+enum class Statistic { Mean, Variance, StdDev, ZScore, Skewness, Kurtosis };
+
+/**
+ * @brief Throw if a statistic is a higher moment, which exponentially weighted
+ * filters do not track
+ *
+ */
+inline void check_ew_statistic(const Statistic statistic) {
+  if ((statistic == Statistic::Skewness) ||
+      (statistic == Statistic::Kurtosis)) {
+    throw std::domain_error(
+        "Skewness and kurtosis need a windowed statistics filter");
+  }
+}
+
+// EXPONENTIALLY WEIGHTED STATISTICS *******************************************
+
+/**
+ * @brief Exponentially weighted mean and variance in one pass
+ *
+ * Both moments are updated together from the deviation of the new sample
+ * (West's weighted incremental algorithm):
+ *    d = x[k] - m[k-1]
+ *    m[k] = m[k-1] + a*d
+ *    v[k] = (1-a)*(v[k-1] + a*d*d)
+ * which never subtracts two large, nearly equal numbers the way
+ * E[x^2] - E[x]^2 does, and costs one filter call instead of two.
+ *
+ * The mean starts at the first sample after construction or reset (see
+ * `seed`), since a mean starting at zero would swamp the variance with the
+ * start-up transient.
+ *
+ * @tparam T - data type used by the filter
+ * @tparam P - Precision policy for the filter constant and moments
+ */
+template <typename T, typename P = Precision<T>>
+class EWStatisticsFilter : public Filter<T> {
+ public:
+  using Coefficient = typename P::coefficient_type;
+  using Accumulator = typename P::accumulator_type;
+
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new EW Statistics Filter object
+   *
+   * @param filter_constant - weight of the newest sample, in (0, 1]
+   * @param statistic - statistic returned by `filter`
+   */
+  EWStatisticsFilter(const Coefficient filter_constant,
+                     const Statistic statistic)
+      : _filter_constant{filter_constant}, _statistic{statistic} {
+    if ((_filter_constant <= 0) || (_filter_constant > 1)) {
+      throw std::domain_error("Filter constant must be in the range (0, 1]");
+    }
+    check_ew_statistic(_statistic);
+  }
+
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Add a new data point and output the selected statistic
+   *
+   * @param data_in - newest arrived data point
+   * @param data_out - reference to the output statistic
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    if (_seed_pending) {
+      seed(data_in);
+    }
+    const Accumulator alpha{_filter_constant};
+    const Accumulator diff{static_cast<Accumulator>(data_in) - _mean};
+    const Accumulator increment{alpha * diff};
+    const Accumulator zscore{_variance > 0 ? diff / std::sqrt(_variance) : 0};
+
+    _mean += increment;
+    _variance = (1 - alpha) * (_variance + diff * increment);
+    data_out = static_cast<T>(select(zscore));
+  }
+
+  /**
+   * @brief Reset the moments. The next sample seeds the mean.
+   *
+   */
+  virtual void reset() override {
+    _mean = 0;
+    _variance = 0;
+    _seed_pending = true;
+  }
+  /**
+   * @brief Start at the statistics of a constant input: mean `value`, zero
+   * variance
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override {
+    _mean = static_cast<Accumulator>(value);
+    _variance = 0;
+    _seed_pending = false;
+  }
+  /**
+   * @brief Set the filter size - NO EFFECT
+   *
+   * @param size - the size of the filter
+   */
+  virtual void set_filter_size(const int size) override { return; };
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<EWStatisticsFilter<T, P>>(*this);
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Exponentially weighted mean
+   *
+   */
+  T mean() const { return static_cast<T>(_mean); }
+  /**
+   * @brief Exponentially weighted variance
+   *
+   */
+  T variance() const { return static_cast<T>(_variance); }
+  /**
+   * @brief Exponentially weighted standard deviation
+   *
+   */
+  T stddev() const { return static_cast<T>(std::sqrt(_variance)); }
+
+ private:
+  /**
+   * @brief The selected statistic, given the z-score of the newest sample
+   *
+   */
+  Accumulator select(const Accumulator zscore) const {
+    switch (_statistic) {
+      case Statistic::Mean:
+        return _mean;
+      case Statistic::Variance:
+        return _variance;
+      case Statistic::StdDev:
+        return std::sqrt(_variance);
+      default:
+        return zscore;
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  Coefficient _filter_constant;  ///< Weight of the newest sample
+  Statistic _statistic;          ///< Statistic returned by `filter`
+  Accumulator _mean{0};          ///< Exponentially weighted mean
+  Accumulator _variance{0};      ///< Exponentially weighted variance
+  bool _seed_pending{true};      ///< Is the next sample used as the seed?
+};
+
+// MULTI-CHANNEL BANK **********************************************************
+
+/**
+ * @brief Exponentially weighted statistics of N streams
+ *
+ * The moments of all channels are kept as arrays and updated with one loop
+ * across channels, with the z-score guard written as a select so the loop
+ * vectorizes. As for the ExponentialFilterBank, planar blocks are run over
+ * time for a tile of channels at once, and `set_gap_policy` makes blocks with
+ * NaN samples apply a GapPolicy per stream (Skip repeats the last output,
+ * Interpolate is held). A stream missing from the seed frame is seeded at
+ * zero, its last valid sample before any data.
+ *
+ * @tparam T - type of each incoming data stream
+ * @tparam N - number of data streams
+ * @tparam P - Precision policy for the filter constant and moments
+ */
+template <typename T, int N, typename P = Precision<T>>
+class EWStatisticsBank {
+ public:
+  using Coefficient = typename P::coefficient_type;
+  using Accumulator = typename P::accumulator_type;
+
+  // CONSTRUCTOR ***************************************************************
+
+  /**
+   * @brief Construct a new EW Statistics Bank object
+   *
+   * @param filter_constant - weight of the newest sample, in (0, 1]
+   * @param statistic - statistic returned by `filter`
+   */
+  EWStatisticsBank(const Coefficient filter_constant, const Statistic statistic)
+      : _alpha{static_cast<Accumulator>(filter_constant)},
+        _statistic{statistic} {
+    if ((filter_constant <= 0) || (filter_constant > 1)) {
+      throw std::domain_error("Filter constant must be in the range (0, 1]");
+    }
+    check_ew_statistic(_statistic);
+  }
+
+  // FILTER FUNCTIONS **********************************************************
+
+  /**
+   * @brief Add one frame of data and output the selected statistic of every
+   * stream
+   *
+   * @param data_in - newest point of every stream
+   * @param data_out - statistic of every stream
+   */
+  void filter(const std::array<T, N>& data_in, std::array<T, N>& data_out) {
+    filter_frames(data_in.data(), data_out.data(), 1,
+                  SampleLayout::Interleaved);
+  }
+
+  /**
+   * @brief Add a block of frames, N values per frame
+   *
+   * @param data_in - `frames` x N input values
+   * @param data_out - `frames` x N output statistics, in the same layout
+   * @param frames - number of frames in the block
+   * @param layout - memory layout of both blocks
+   */
+  void filter_frames(const T* data_in, T* data_out, const int frames,
+                     const SampleLayout layout) {
+    if ((frames > 0) && _seed_pending) {
+      std::array<T, N> first;
+      for (int cc{0}; cc < N; ++cc) {
+        first[cc] = layout == SampleLayout::Interleaved
+                        ? data_in[cc]
+                        : data_in[static_cast<long>(cc) * frames];
+        first[cc] = is_gap(first[cc]) ? _last_valid[cc] : first[cc];
+      }
+      seed(first);
+    }
+
+    if (_gaps_handled && has_gaps(data_in, static_cast<long>(N) * frames)) {
+      update_frames<true>(data_in, data_out, frames, layout);
+    } else {
+      update_frames<false>(data_in, data_out, frames, layout);
+    }
+  }
+
+  /**
+   * @brief Reset the moments. The next frame seeds the means.
+   *
+   */
+  void reset() {
+    _mean.fill(0);
+    _variance.fill(0);
+    _last_valid.fill(0);
+    _last_output.fill(0);
+    _seed_pending = true;
+  }
+
+  /**
+   * @brief Start at the statistics of constant inputs
+   *
+   * @param values - the constant input of each stream
+   */
+  void seed(const std::array<T, N>& values) {
+    for (int cc{0}; cc < N; ++cc) {
+      _mean[cc] = static_cast<Accumulator>(values[cc]);
+      _last_valid[cc] = values[cc];
+    }
+    _variance.fill(0);
+    _seed_pending = false;
+  }
+
+  /**
+   * @brief Handle missing (NaN) samples according to a policy instead of
+   * letting them poison the moments
+   *
+   * @param policy - handling of NaN samples
+   */
+  void set_gap_policy(const GapPolicy policy) {
+    _gap_policy = policy;
+    _gaps_handled = true;
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Exponentially weighted mean of each stream
+   *
+   */
+  const std::array<Accumulator, N>& mean() const { return _mean; }
+  /**
+   * @brief Exponentially weighted variance of each stream
+   *
+   */
+  const std::array<Accumulator, N>& variance() const { return _variance; }
+
+ private:
+  /**
+   * @brief Update every channel with a block of frames
+   *
+   * @tparam kGaps - apply the gap policy to NaN samples
+   */
+  template <bool kGaps>
+  void update_frames(const T* data_in, T* data_out, const int frames,
+                     const SampleLayout layout) {
+    if (layout == SampleLayout::Interleaved) {
+      for (int ff{0}; ff < frames; ++ff) {
+        update<kGaps>(data_in + static_cast<long>(ff) * N,
+                      data_out + static_cast<long>(ff) * N, 1, 0, N);
+      }
+      return;
+    }
+    for (int c0{0}; c0 < N; c0 += kTile) {
+      const int tile{std::min(kTile, N - c0)};
+      for (int ff{0}; ff < frames; ++ff) {
+        update<kGaps>(data_in + ff, data_out + ff, frames, c0, tile);
+      }
+    }
+  }
+
+  /**
+   * @brief Update channels [first, first + count) with one sample each, read
+   * `stride` values apart starting at channel `first`
+   *
+   * With kGaps, a NaN sample is replaced by the channel's last valid sample;
+   * Skip then keeps the moments and repeats the last output, and MarkInvalid
+   * outputs NaN. The policy is applied with selects, so the loop stays
+   * branch-free.
+   */
+  template <bool kGaps>
+  void update(const T* data_in, T* data_out, const long stride,
+              const int first, const int count) {
+    const Accumulator alpha{_alpha};
+    const bool skip{kGaps && (_gap_policy == GapPolicy::Skip)};
+    const bool mark{kGaps && (_gap_policy == GapPolicy::MarkInvalid)};
+    const T* in{data_in + first * stride};
+    T* out{data_out + first * stride};
+    for (int cc{0}; cc < count; ++cc) {
+      Accumulator& mean{_mean[first + cc]};
+      Accumulator& variance{_variance[first + cc]};
+      T& last_valid{_last_valid[first + cc]};
+      T& last_output{_last_output[first + cc]};
+
+      const T sample{in[cc * stride]};
+      const bool valid{!kGaps || !is_gap(sample)};
+      last_valid = valid ? sample : last_valid;
+
+      const Accumulator diff{static_cast<Accumulator>(last_valid) - mean};
+      const Accumulator increment{alpha * diff};
+      const Accumulator deviation{std::sqrt(variance)};
+      const Accumulator zscore{variance > 0 ? diff / deviation : 0};
+
+      const bool keep{skip && !valid};
+      mean = keep ? mean : mean + increment;
+      variance = keep ? variance : (1 - alpha) * (variance + diff * increment);
+
+      Accumulator result{zscore};
+      result = _statistic == Statistic::Mean ? mean : result;
+      result = _statistic == Statistic::Variance ? variance : result;
+      result = _statistic == Statistic::StdDev ? std::sqrt(variance) : result;
+      last_output = keep ? last_output : static_cast<T>(result);
+      out[cc * stride] = mark && !valid ? kGap : last_output;
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  static constexpr int kTile{8};  ///< Channels filtered together when planar
+  static constexpr T kGap{std::numeric_limits<T>::quiet_NaN()};
+
+  Accumulator _alpha;                      ///< Weight of the newest sample
+  Statistic _statistic;                    ///< Statistic returned
+  std::array<Accumulator, N> _mean{};      ///< Weighted mean per stream
+  std::array<Accumulator, N> _variance{};  ///< Weighted variance per stream
+  std::array<T, N> _last_valid{};          ///< Last valid sample per stream
+  std::array<T, N> _last_output{};         ///< Last output per stream
+  GapPolicy _gap_policy{GapPolicy::Hold};  ///< Handling of NaN samples
+  bool _gaps_handled{false};               ///< Was a gap policy set?
+  bool _seed_pending{true};                ///< Is the next frame the seed?
+};
+
+// WINDOWED STATISTICS *********************************************************
+
+/**
+ * @brief Mean, variance, skewness and kurtosis over a sliding window
+ *
+ * The window is kept in the same ring buffer as the MovingAverageFilter, and
+ * the mean and central moment sums M2, M3, M4 are updated in O(1) per sample
+ * by removing the evicted point and adding the new one with Pebay's
+ * incremental formulas. These work on deviations from the mean, so they stay
+ * accurate for signals with a large offset. To stop rounding errors
+ * accumulating, the moments are recomputed exactly from the window each time
+ * the ring buffer wraps, which costs O(1) per sample on average.
+ *
+ * A single filter serves every statistic: `filter` outputs the one chosen at
+ * construction, and the accessors give the others for the same window, so
+ * several moments no longer need one stored window each. Moments are those of
+ * the samples in the window (population moments, no n-1 correction), and the
+ * kurtosis is the excess kurtosis. Before the window is full, the statistics
+ * cover the samples seen so far.
+ *
+ * @tparam T - data type used by the filter
+ * @tparam P - Precision policy for the moment sums
+ */
+template <typename T, typename P = Precision<T>>
+class WindowedStatisticsFilter : public Filter<T> {
+ public:
+  using Accumulator = typename P::accumulator_type;
+
+  // CONSTRUCTORS **************************************************************
+
+  /**
+   * @brief Construct a new Windowed Statistics Filter object
+   *
+   * @param filter_size - the number of data points in the window
+   * @param statistic - statistic returned by `filter`
+   */
+  WindowedStatisticsFilter(const int filter_size, const Statistic statistic)
+      : _statistic{statistic} {
+    set_filter_size(filter_size);
+  }
+
+  // FILTERING FUNCTIONS *******************************************************
+
+  /**
+   * @brief Slide the window by one data point and output the selected
+   * statistic
+   *
+   * @param data_in - newest arrived data point
+   * @param data_out - reference to the output statistic
+   */
+  virtual void filter(const T data_in, T& data_out) override {
+    const Accumulator x{static_cast<Accumulator>(data_in)};
+    const Accumulator zscore{_m2 > 0 ? (x - _mean) / std::sqrt(_m2 / _count)
+                                     : 0};
+
+    const T oldest{_data.push(data_in)};
+    if (primed()) {
+      remove(static_cast<Accumulator>(oldest));
+    }
+    add(x);
+    if (primed() && (_data.head() == 0)) {
+      resync();
+    }
+
+    switch (_statistic) {
+      case Statistic::Mean:
+        data_out = mean();
+        break;
+      case Statistic::Variance:
+        data_out = variance();
+        break;
+      case Statistic::StdDev:
+        data_out = stddev();
+        break;
+      case Statistic::ZScore:
+        data_out = static_cast<T>(zscore);
+        break;
+      case Statistic::Skewness:
+        data_out = skewness();
+        break;
+      case Statistic::Kurtosis:
+        data_out = kurtosis();
+        break;
+    }
+  }
+
+  /**
+   * @brief Reset the filter by emptying the window
+   *
+   */
+  virtual void reset() override {
+    _data.reset();
+    _count = 0;
+    _mean = 0;
+    _m2 = 0;
+    _m3 = 0;
+    _m4 = 0;
+  }
+
+  /**
+   * @brief Fill the window with a constant input
+   *
+   * @param value - the constant input the filter is settled on
+   */
+  virtual void seed(const T value) override {
+    reset();
+    _data.fill(value);
+    _count = _filter_size;
+    _mean = static_cast<Accumulator>(value);
+  }
+
+  /**
+   * @brief Set the window size. Note that this resets the filter.
+   *
+   * @param size - the number of data points in the window
+   */
+  virtual void set_filter_size(const int size) override {
+    if (size < 1) {
+      throw std::domain_error("Window size must be positive");
+    }
+    _filter_size = size;
+    _data.resize(_filter_size);
+    reset();
+  }
+
+  /**
+   * @brief Return a cast pointer to Filter<T> for creating multi-filter objects
+   *
+   * @return std::unique_ptr<Filter<T>>
+   */
+  virtual std::unique_ptr<Filter<T>> clone() const override {
+    return std::make_unique<WindowedStatisticsFilter<T, P>>(*this);
+  }
+
+  // ACCESSORS *****************************************************************
+
+  /**
+   * @brief Has the window been filled since the last reset?
+   *
+   */
+  bool primed() const { return _count >= _filter_size; }
+  /**
+   * @brief Mean of the window
+   *
+   */
+  T mean() const { return static_cast<T>(_mean); }
+  /**
+   * @brief Variance of the window
+   *
+   */
+  T variance() const {
+    return static_cast<T>(_count > 0 ? _m2 / _count : 0);
+  }
+  /**
+   * @brief Standard deviation of the window
+   *
+   */
+  T stddev() const {
+    return static_cast<T>(std::sqrt(_count > 0 ? _m2 / _count : 0));
+  }
+  /**
+   * @brief Skewness of the window, zero while its variance is zero
+   *
+   */
+  T skewness() const {
+    return static_cast<T>(_m2 > 0 ? std::sqrt(Accumulator(_count)) * _m3 /
+                                        std::pow(_m2, Accumulator{1.5})
+                                  : 0);
+  }
+  /**
+   * @brief Excess kurtosis of the window, zero while its variance is zero
+   *
+   */
+  T kurtosis() const {
+    return static_cast<T>(_m2 > 0 ? _count * _m4 / (_m2 * _m2) - 3 : 0);
+  }
+
+ private:
+  // PRIVATE SUPPORT FUNCTIONS *************************************************
+
+  /**
+   * @brief Add a point to the moments (n -> n + 1)
+   *
+   */
+  void add(const Accumulator x) {
+    const Accumulator n{static_cast<Accumulator>(_count)};
+    const Accumulator n1{n + 1};
+    const Accumulator delta{x - _mean};
+    const Accumulator delta_n{delta / n1};
+    const Accumulator delta_n2{delta_n * delta_n};
+    const Accumulator term{delta * delta_n * n};
+
+    _mean += delta_n;
+    _m4 += term * delta_n2 * (n1 * n1 - 3 * n1 + 3) + 6 * delta_n2 * _m2 -
+           4 * delta_n * _m3;
+    _m3 += term * delta_n * (n1 - 2) - 3 * delta_n * _m2;
+    _m2 += term;
+    ++_count;
+  }
+
+  /**
+   * @brief Remove a point from the moments (n -> n - 1), inverting `add`
+   *
+   */
+  void remove(const Accumulator x) {
+    if (_count <= 1) {
+      _count = 0;
+      _mean = _m2 = _m3 = _m4 = 0;
+      return;
+    }
+    const Accumulator n{static_cast<Accumulator>(_count)};
+    const Accumulator delta{n * (x - _mean) / (n - 1)};
+    const Accumulator delta_n{delta / n};
+    const Accumulator delta_n2{delta_n * delta_n};
+    const Accumulator term{delta * delta_n * (n - 1)};
+
+    _mean -= delta_n;
+    _m2 -= term;
+    _m3 -= term * delta_n * (n - 2) - 3 * delta_n * _m2;
+    _m4 -= term * delta_n2 * (n * n - 3 * n + 3) + 6 * delta_n2 * _m2 -
+           4 * delta_n * _m3;
+    --_count;
+  }
+
+  /**
+   * @brief Recompute the moments exactly from the full window (two passes)
+   *
+   */
+  void resync() {
+    const T* data{_data.data()};
+    Accumulator sum{0};
+    for (int ii{0}; ii < _filter_size; ++ii) {
+      sum += static_cast<Accumulator>(data[ii]);
+    }
+    _mean = sum / _filter_size;
+
+    _m2 = _m3 = _m4 = 0;
+    for (int ii{0}; ii < _filter_size; ++ii) {
+      const Accumulator d{static_cast<Accumulator>(data[ii]) - _mean};
+      const Accumulator d2{d * d};
+      _m2 += d2;
+      _m3 += d2 * d;
+      _m4 += d2 * d2;
+    }
+  }
+
+  // VARIABLES *****************************************************************
+
+  RingBuffer<T> _data{};  ///< Internal circular data buffer
+  int _filter_size{};     ///< Size of the internal data buffer
+  int _count{0};          ///< Points in the window, up to _filter_size
+  Statistic _statistic;   ///< Statistic returned by `filter`
+
+  Accumulator _mean{0};  ///< Mean of the window
+  Accumulator _m2{0};    ///< Sum of squared deviations from the mean
+  Accumulator _m3{0};    ///< Sum of cubed deviations from the mean
+  Accumulator _m4{0};    ///< Sum of fourth-power deviations from the mean
+};
+
+#endif
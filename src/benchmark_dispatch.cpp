@@ -0,0 +1,76 @@
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "dispatch.hpp"
+
+constexpr int kTaps{64};
+constexpr int kBlock{1 << 14};
+constexpr int kChannels{64};
+constexpr int kFrames{1 << 10};
+constexpr int kRuns{200};
+
+/**
+ * @brief Time a kernel call and print ns per output sample
+ *
+ */
+template <typename F>
+void run(const std::string& name, const int samples, F kernel) {
+  kernel();
+  const auto start{std::chrono::steady_clock::now()};
+  for (int rr{0}; rr < kRuns; ++rr) {
+    kernel();
+  }
+  const auto stop{std::chrono::steady_clock::now()};
+
+  const double ns{
+      std::chrono::duration<double, std::nano>(stop - start).count()};
+  std::cout << std::left << std::setw(28) << name << std::right << std::setw(10)
+            << std::fixed << std::setprecision(4)
+            << ns / (static_cast<double>(kRuns) * samples) << " ns/sample\n";
+}
+
+int main() {
+  std::cout << "best instruction set: " << isa_name(best_isa())
+            << ", selected: " << isa_name(active_isa())
+            << " (override with FILTERING_ISA)\n\n";
+
+  std::vector<float> taps(kTaps, 1.0f / kTaps);
+  std::vector<float> signal(kBlock + kTaps);
+  for (std::size_t ii{0}; ii < signal.size(); ++ii) {
+    signal[ii] = static_cast<float>(sin(0.01 * ii));
+  }
+  std::vector<float> filtered(kBlock);
+
+  std::vector<float> alpha(kChannels, 0.1f);
+  std::vector<float> one_minus_alpha(kChannels, 0.9f);
+  std::vector<float> state(kChannels, 0.0f);
+  std::vector<float> frames_in(kChannels * kFrames);
+  std::vector<float> frames_out(kChannels * kFrames);
+  for (std::size_t ii{0}; ii < frames_in.size(); ++ii) {
+    frames_in[ii] = static_cast<float>(sin(0.001 * ii));
+  }
+
+  for (const Isa isa : {Isa::Generic, Isa::SSE2, Isa::AVX2, Isa::AVX512,
+                        Isa::NEON}) {
+    if (!isa_supported(isa)) {
+      continue;
+    }
+    const std::string suffix{std::string{" ("} + isa_name(isa) + ")" +
+                             (isa == active_isa() ? " *" : "")};
+
+    const auto convolve{fir_convolve_for<float>(isa)};
+    run("FIR, 64 taps" + suffix, kBlock, [&]() {
+      convolve(taps.data(), kTaps, signal.data(), filtered.data(), kBlock);
+    });
+
+    const auto bank{exponential_bank_for<float, float>(isa)};
+    run("Exponential bank" + suffix, kChannels * kFrames, [&]() {
+      bank(alpha.data(), one_minus_alpha.data(), state.data(),
+           frames_in.data(), frames_out.data(), kChannels, kFrames);
+    });
+  }
+}
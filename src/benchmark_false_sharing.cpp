@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aligned.hpp"
+#include "filter.hpp"
+
+constexpr int kSamples{1 << 24};
+
+/**
+ * @brief Update one filter per thread concurrently and print ns per sample
+ *
+ * The filters are called through Filter<double>& so that their state really
+ * is written back to memory on every sample.
+ *
+ */
+void run(const std::string& name, const std::vector<Filter<double>*>& filters) {
+  const int threads{static_cast<int>(filters.size())};
+  std::vector<double> results(threads);
+
+  const auto start{std::chrono::steady_clock::now()};
+  std::vector<std::thread> workers;
+  for (int tt{0}; tt < threads; ++tt) {
+    workers.emplace_back([&filters, &results, tt]() {
+      Filter<double>& filter{*filters[tt]};
+      double data_out{0};
+      for (int ii{0}; ii < kSamples; ++ii) {
+        filter.filter(ii & 0xff, data_out);
+      }
+      results[tt] = data_out;
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  const auto stop{std::chrono::steady_clock::now()};
+
+  const double ns{
+      std::chrono::duration<double, std::nano>(stop - start).count()};
+  std::cout << std::left << std::setw(36) << name << std::right << std::setw(10)
+            << std::fixed << std::setprecision(3)
+            << ns / (static_cast<double>(kSamples) * threads)
+            << " ns/sample   (checksum " << results[0] << ")\n";
+}
+
+/**
+ * @brief Raw pointers to owned filters
+ *
+ */
+template <typename Container>
+std::vector<Filter<double>*> pointers(Container& filters) {
+  std::vector<Filter<double>*> result;
+  for (auto& filter : filters) {
+    result.push_back(&*filter);
+  }
+  return result;
+}
+
+int main() {
+  const int threads{
+      static_cast<int>(std::max(2U, std::thread::hardware_concurrency()))};
+  const ExponentialFilter<double> prototype{0.1};
+
+  std::cout << threads << " threads, " << sizeof(ExponentialFilter<double>)
+            << "-byte ExponentialFilter, " << kCacheLineSize
+            << "-byte cache lines";
+#ifdef __cpp_lib_hardware_interference_size
+  std::cout << " (compiler reports "
+            << std::hardware_destructive_interference_size << ")";
+#endif
+  std::cout << "\n";
+
+  // Side by side in one array
+  std::vector<ExponentialFilter<double>> packed(threads, prototype);
+  std::vector<Filter<double>*> packed_pointers;
+  for (auto& filter : packed) {
+    packed_pointers.push_back(&filter);
+  }
+  run("Packed array", packed_pointers);
+
+  std::vector<CacheAligned<ExponentialFilter<double>>> aligned(
+      threads, CacheAligned<ExponentialFilter<double>>{prototype});
+  std::vector<Filter<double>*> aligned_pointers;
+  for (auto& filter : aligned) {
+    aligned_pointers.push_back(&filter);
+  }
+  run("CacheAligned array", aligned_pointers);
+
+  // Adjacent heap allocations
+  std::vector<std::unique_ptr<Filter<double>>> cloned(threads);
+  for (auto& filter : cloned) {
+    filter = prototype.clone();
+  }
+  run("clone()", pointers(cloned));
+
+  const CacheAligned<ExponentialFilter<double>> aligned_prototype{prototype};
+  for (auto& filter : cloned) {
+    filter = aligned_prototype.clone();
+  }
+  run("CacheAligned clone()", pointers(cloned));
+}
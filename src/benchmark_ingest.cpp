@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "filter.hpp"
+#include "ingest.hpp"
+
+constexpr int kChannels{512};
+constexpr int kSamplesPerProducer{1 << 20};
+
+/**
+ * @brief Start `producers` threads that each push samples for an overlapping
+ * window of channels, and return the throughput [million samples/s]
+ *
+ */
+template <typename Push, typename Finish>
+double ingest(const int producers, Push push, Finish finish) {
+  const auto start{std::chrono::steady_clock::now()};
+  std::vector<std::thread> threads;
+  for (int pp{0}; pp < producers; ++pp) {
+    threads.emplace_back([pp, &push]() {
+      const int first{pp * kChannels / 8};
+      for (int ii{0}; ii < kSamplesPerProducer; ++ii) {
+        push((first + ii % (kChannels / 2)) % kChannels, 1.0 * ii);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  finish();
+  const auto stop{std::chrono::steady_clock::now()};
+  return 1e-6 * producers * kSamplesPerProducer /
+         std::chrono::duration<double>(stop - start).count();
+}
+
+int main() {
+  const int cores{
+      static_cast<int>(std::max(1U, std::thread::hardware_concurrency()))};
+  const ExponentialFilter<double> prototype{0.1};
+
+  std::cout << kChannels << " channels, " << cores << " hardware threads\n\n"
+            << std::setw(10) << "producers" << std::setw(8) << "shards"
+            << std::setw(16) << "mutex [MS/s]" << std::setw(18)
+            << "sharded [MS/s]" << std::setw(12) << "imbalance"
+            << std::setw(12) << "stalls\n";
+
+  for (int producers{1}; producers <= std::max(4, cores); producers *= 2) {
+    // Baseline: one mutex around every channel's filter
+    std::vector<std::unique_ptr<Filter<double>>> filters(kChannels);
+    for (auto& filter : filters) {
+      filter = prototype.clone();
+    }
+    std::mutex mutex;
+    const double locked{ingest(
+        producers,
+        [&](const int channel, const double value) {
+          std::lock_guard<std::mutex> lock{mutex};
+          double data_out;
+          filters[channel]->filter(value, data_out);
+        },
+        []() {})};
+
+    const int shards{std::max(1, cores - producers)};
+    ShardedFilterBank<double> bank{prototype, kChannels, shards};
+    const double sharded{ingest(
+        producers,
+        [&](const int channel, const double value) {
+          bank.push(channel, value);
+        },
+        [&]() { bank.flush(); })};
+
+    std::uint64_t stalls{0};
+    for (const auto& stat : bank.stats()) {
+      stalls += stat.full_waits;
+    }
+    std::cout << std::setw(10) << producers << std::setw(8) << shards
+              << std::fixed << std::setprecision(1) << std::setw(16) << locked
+              << std::setw(18) << sharded << std::setprecision(3)
+              << std::setw(12) << bank.load_imbalance() << std::setw(11)
+              << stalls << "\n";
+  }
+}
@@ -0,0 +1,297 @@
+#include <time.h>
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define FILTERING_HAS_TSC
+#endif
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "chain.hpp"
+#include "multistream.hpp"
+#include "numa.hpp"
+
+constexpr int kStreams{16};
+constexpr int kWarmUpCalls{10000};
+constexpr int kSignalLength{4096};
+
+// TIMER ***********************************************************************
+
+/**
+ * @brief Timer for a single call: the time-stamp counter where there is one,
+ * converted to ns against the monotonic clock, and clock_gettime elsewhere
+ *
+ */
+class Timer {
+ public:
+  Timer() {
+#ifdef FILTERING_HAS_TSC
+    const auto began{std::chrono::steady_clock::now()};
+    const std::uint64_t ticks{stop()};
+    while (std::chrono::steady_clock::now() - began <
+           std::chrono::milliseconds(50)) {
+    }
+    const auto elapsed{std::chrono::steady_clock::now() - began};
+    _ns_per_tick = std::chrono::duration<double, std::nano>(elapsed).count() /
+                   static_cast<double>(stop() - ticks);
+#endif
+    _overhead = std::numeric_limits<double>::infinity();
+    for (int ii{0}; ii < 10000; ++ii) {
+      const std::uint64_t begin{start()};
+      _overhead = std::min(_overhead, ns(stop() - begin));
+    }
+  }
+
+  /**
+   * @brief Read the timer before the timed code, after earlier instructions
+   * complete
+   *
+   */
+  std::uint64_t start() const {
+#ifdef FILTERING_HAS_TSC
+    _mm_lfence();
+    const std::uint64_t ticks{__rdtsc()};
+    _mm_lfence();
+    return ticks;
+#else
+    return monotonic();
+#endif
+  }
+
+  /**
+   * @brief Read the timer after the timed code completes
+   *
+   */
+  std::uint64_t stop() const {
+#ifdef FILTERING_HAS_TSC
+    unsigned int cpu;
+    const std::uint64_t ticks{__rdtscp(&cpu)};
+    _mm_lfence();
+    return ticks;
+#else
+    return monotonic();
+#endif
+  }
+
+  /**
+   * @brief Duration of a number of ticks [ns]
+   *
+   */
+  double ns(const std::uint64_t ticks) const { return ticks * _ns_per_tick; }
+  /**
+   * @brief Cost of reading the timer twice, subtracted from every call [ns]
+   *
+   */
+  double overhead() const { return _overhead; }
+
+  const char* name() const {
+#ifdef FILTERING_HAS_TSC
+    return "rdtsc";
+#else
+    return "clock_gettime";
+#endif
+  }
+
+ private:
+  static std::uint64_t monotonic() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<std::uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+  }
+
+  double _ns_per_tick{1};  ///< Tick length [ns]
+  double _overhead{0};     ///< Timer overhead [ns]
+};
+
+// MEASUREMENT *****************************************************************
+
+/**
+ * @brief Default size of the buffer walked to evict the caches [MB]: twice
+ * the last level cache, at most 32 MB so a cold call takes milliseconds
+ * rather than the tenths of a second a server LLC would need
+ *
+ */
+int default_eviction_mb() {
+  long bytes{0};
+#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+  bytes = ::sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+  return bytes > 0 ? static_cast<int>(std::clamp((2 * bytes) >> 20, 1L, 32L))
+                   : 32;
+}
+
+/**
+ * @brief Measure every call of a function, and print the percentiles
+ *
+ * @param name - row label
+ * @param timer - per-call timer
+ * @param calls - number of timed calls
+ * @param evict - caches to evict before each call, or empty for a warm cache
+ * @param call - the call, given its index
+ */
+void measure(const std::string& name, const Timer& timer, const int calls,
+             std::vector<char>& evict, const std::function<void(int)>& call) {
+  for (int ii{0}; ii < kWarmUpCalls; ++ii) {
+    call(ii);
+  }
+
+  std::vector<double> latencies(calls);
+  for (int ii{0}; ii < calls; ++ii) {
+    for (std::size_t bb{0}; bb < evict.size(); bb += 64) {
+      ++evict[bb];
+    }
+    const std::uint64_t begin{timer.start()};
+    call(ii);
+    const std::uint64_t end{timer.stop()};
+    latencies[ii] = std::max(0.0, timer.ns(end - begin) - timer.overhead());
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&](const double p) {
+    const auto rank{static_cast<long>(std::ceil(p * calls)) - 1};
+    return latencies[std::max(0L, rank)];
+  };
+  std::cout << std::left << std::setw(30) << name << std::right << std::fixed
+            << std::setprecision(1) << std::setw(6)
+            << (evict.empty() ? "warm" : "cold") << std::setw(10)
+            << percentile(0.5) << std::setw(10) << percentile(0.99)
+            << std::setw(10) << percentile(0.999) << std::setw(10)
+            << latencies.back() << "\n";
+}
+
+/**
+ * @brief Print the command line usage
+ *
+ */
+void usage(const char* name) {
+  std::cerr
+      << "Usage: " << name << " [options]\n"
+      << "Measure the latency of single filter calls, with warm and cold\n"
+      << "caches, and print percentiles in ns.\n\n"
+      << "  -f SPEC        filter to measure (repeatable, default a set of\n"
+      << "                 common filters)\n"
+      << "  -n CALLS       timed calls with a warm cache (default 100000)\n"
+      << "  --cold CALLS   timed calls with a cold cache (default 1000)\n"
+      << "  --evict MB     data walked before each cold call (default twice\n"
+      << "                 the last level cache, at most 32 MB)\n"
+      << "  --cpu CPU      CPU to pin to (default the current one)\n";
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> specs;
+  int warm_calls{100000};
+  int cold_calls{1000};
+  int evict_mb{default_eviction_mb()};
+  int cpu{0};
+#ifdef __linux__
+  cpu = std::max(0, ::sched_getcpu());
+#endif
+
+  try {
+    for (int ii{1}; ii < argc; ++ii) {
+      const std::string arg{argv[ii]};
+      const auto value = [&]() {
+        if (ii + 1 >= argc) {
+          throw std::invalid_argument("Missing value for " + arg);
+        }
+        return std::string{argv[++ii]};
+      };
+
+      if (arg == "-f") {
+        specs.push_back(value());
+      } else if (arg == "-n") {
+        warm_calls = std::stoi(value());
+      } else if (arg == "--cold") {
+        cold_calls = std::stoi(value());
+      } else if (arg == "--evict") {
+        evict_mb = std::stoi(value());
+      } else if (arg == "--cpu") {
+        cpu = std::stoi(value());
+      } else if ((arg == "-h") || (arg == "--help")) {
+        usage(argv[0]);
+        return 0;
+      } else {
+        throw std::invalid_argument("Unknown option " + arg);
+      }
+    }
+    if ((warm_calls < 1) || (cold_calls < 1)) {
+      throw std::domain_error("Number of calls must be positive");
+    }
+    if (evict_mb < 1) {
+      throw std::domain_error("Eviction size must be positive");
+    }
+    if (specs.empty()) {
+      specs = {"exp:0.1", "ma:32", "lp:1:0.01", "sg:21:3", "wstat:100:std"};
+    }
+
+    const bool pinned{pin_current_thread({cpu})};
+    const Timer timer;
+    std::cout << "timer: " << timer.name() << " (overhead " << std::fixed
+              << std::setprecision(1) << timer.overhead() << " ns), "
+              << (pinned ? "pinned to CPU " + std::to_string(cpu)
+                         : std::string{"not pinned"})
+              << "\n\n"
+              << std::left << std::setw(30) << "filter" << std::right
+              << std::setw(6) << "cache" << std::setw(10) << "p50"
+              << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+              << std::setw(10) << "max" << "\n";
+
+    std::vector<double> signal(kSignalLength);
+    for (int ii{0}; ii < kSignalLength; ++ii) {
+      signal[ii] = std::sin(0.01 * ii) + 0.1 * std::sin(1.3 * ii);
+    }
+    std::vector<char> no_eviction;
+    std::vector<char> eviction(static_cast<std::size_t>(evict_mb) << 20);
+    double sink{0};
+
+    for (const auto& spec : specs) {
+      const std::unique_ptr<Filter<double>> filter{make_filter<double>(spec)};
+      const auto call = [&](const int ind) {
+        double output;
+        filter->filter(signal[ind % kSignalLength], output);
+        sink += output;
+      };
+      measure(spec, timer, warm_calls, no_eviction, call);
+      measure(spec, timer, cold_calls, eviction, call);
+    }
+
+    const std::unique_ptr<Filter<double>> prototype{
+        make_filter<double>(specs[0])};
+    MultiStreamFilter<double, kStreams> streams{*prototype};
+    const std::string name{"MultiStream<" + std::to_string(kStreams) + "> " +
+                           specs[0]};
+    const auto call = [&](const int ind) {
+      std::array<double, kStreams> data_in;
+      std::array<double, kStreams> data_out;
+      for (int ss{0}; ss < kStreams; ++ss) {
+        data_in[ss] = signal[(ind + ss) % kSignalLength];
+      }
+      streams.filter(data_in, data_out);
+      sink += data_out[0];
+    };
+    measure(name, timer, warm_calls, no_eviction, call);
+    measure(name, timer, cold_calls, eviction, call);
+
+    if (std::isnan(sink)) {
+      std::cout << "\n";  // keeps the outputs alive
+    }
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+}
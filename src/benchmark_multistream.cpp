@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "filter.hpp"
+#include "multistream.hpp"
+
+constexpr int kChannels{64};
+constexpr int kFrames{256};
+constexpr int kPackets{20000};
+
+/**
+ * @brief Time a packet filtering function and print ns per sample
+ *
+ * @tparam F - callable taking (const double* in, double* out)
+ */
+template <typename F>
+void run(const std::string& name, F filter_packet,
+         const std::vector<double>& packet) {
+  std::vector<double> data_out(packet.size());
+
+  const auto start{std::chrono::steady_clock::now()};
+  for (int pp{0}; pp < kPackets; ++pp) {
+    filter_packet(packet.data(), data_out.data());
+  }
+  const auto stop{std::chrono::steady_clock::now()};
+
+  const double ns{
+      std::chrono::duration<double, std::nano>(stop - start).count()};
+  std::cout << std::left << std::setw(44) << name << std::right << std::setw(10)
+            << std::fixed << std::setprecision(3)
+            << ns / kPackets / kChannels / kFrames << " ns/sample\n";
+}
+
+/**
+ * @brief A MultiStreamFilter with a clone of `filter` on every channel
+ *
+ */
+std::unique_ptr<MultiStreamFilter<double, kChannels>> make_multi(
+    const Filter<double>& filter) {
+  return std::make_unique<MultiStreamFilter<double, kChannels>>(filter);
+}
+
+int main() {
+  // One packet, in both layouts
+  std::vector<double> row_major(kChannels * kFrames);
+  std::vector<double> column_major(kChannels * kFrames);
+  for (int ff{0}; ff < kFrames; ++ff) {
+    for (int cc{0}; cc < kChannels; ++cc) {
+      const double value{sin(0.01 * ff * (cc + 1))};
+      row_major[ff * kChannels + cc] = value;
+      column_major[cc * kFrames + ff] = value;
+    }
+  }
+
+  std::cout << "Packets of " << kFrames << " frames x " << kChannels
+            << " channels\n\nExponential, alpha 0.1\n";
+  {
+    auto multi{make_multi(ExponentialFilter<double>{0.1})};
+    run(
+        "MultiStreamFilter, frame by frame",
+        [&](const double* data_in, double* data_out) {
+          std::array<double, kChannels> frame_in;
+          std::array<double, kChannels> frame_out;
+          for (int ff{0}; ff < kFrames; ++ff) {
+            std::copy(data_in + ff * kChannels,
+                      data_in + (ff + 1) * kChannels, frame_in.begin());
+            multi->filter(frame_in, frame_out);
+            std::copy(frame_out.begin(), frame_out.end(),
+                      data_out + ff * kChannels);
+          }
+        },
+        row_major);
+    run(
+        "MultiStreamFilter, row-major block",
+        [&](const double* data_in, double* data_out) {
+          multi->filter_frames(data_in, data_out, kFrames,
+                               SampleLayout::Interleaved);
+        },
+        row_major);
+    run(
+        "MultiStreamFilter, column-major block",
+        [&](const double* data_in, double* data_out) {
+          multi->filter_frames(data_in, data_out, kFrames,
+                               SampleLayout::Planar);
+        },
+        column_major);
+
+    ExponentialFilterBank<double, kChannels> bank{0.1};
+    run(
+        "ExponentialFilterBank, row-major block",
+        [&](const double* data_in, double* data_out) {
+          bank.filter_frames(data_in, data_out, kFrames,
+                             SampleLayout::Interleaved);
+        },
+        row_major);
+    run(
+        "ExponentialFilterBank, column-major block",
+        [&](const double* data_in, double* data_out) {
+          bank.filter_frames(data_in, data_out, kFrames,
+                             SampleLayout::Planar);
+        },
+        column_major);
+  }
+
+  std::cout << "\nMoving average, window 32\n";
+  {
+    auto multi{make_multi(MovingAverageFilter<double>{32})};
+    run(
+        "MultiStreamFilter, row-major block",
+        [&](const double* data_in, double* data_out) {
+          multi->filter_frames(data_in, data_out, kFrames,
+                               SampleLayout::Interleaved);
+        },
+        row_major);
+    run(
+        "MultiStreamFilter, column-major block",
+        [&](const double* data_in, double* data_out) {
+          multi->filter_frames(data_in, data_out, kFrames,
+                               SampleLayout::Planar);
+        },
+        column_major);
+  }
+}
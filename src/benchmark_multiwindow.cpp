@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "filter.hpp"
+
+constexpr int kChannels{64};
+constexpr int kFrames{1 << 16};
+const std::vector<int> kWindows{10, 100, 1000};
+
+/**
+ * @brief Time a function filtering every channel for `kFrames` frames and
+ * print ns per input sample and the bytes of stored windows
+ *
+ */
+template <typename F>
+void run(const std::string& name, const std::size_t footprint, F filter_frame,
+         const std::vector<double>& signal) {
+  double checksum{0};
+  const auto start{std::chrono::steady_clock::now()};
+  for (int ff{0}; ff < kFrames; ++ff) {
+    checksum += filter_frame(signal[ff]);
+  }
+  const auto stop{std::chrono::steady_clock::now()};
+
+  const double ns{
+      std::chrono::duration<double, std::nano>(stop - start).count()};
+  std::cout << std::left << std::setw(36) << name << std::right << std::setw(10)
+            << std::fixed << std::setprecision(3)
+            << ns / (static_cast<double>(kFrames) * kChannels) << " ns/sample"
+            << std::setw(10) << footprint / 1024 << " KiB   (checksum "
+            << checksum << ")\n";
+}
+
+int main() {
+  std::vector<double> signal(kFrames);
+  for (int ff{0}; ff < kFrames; ++ff) {
+    signal[ff] = sin(0.01 * ff) + 0.1 * sin(0.37 * ff);
+  }
+
+  int total{0};
+  int largest{0};
+  for (const int window : kWindows) {
+    total += window;
+    largest = std::max(largest, window);
+  }
+  std::cout << kChannels << " channels, windows of 10, 100 and 1000\n";
+
+  std::vector<std::vector<MovingAverageFilter<double>>> separate(kChannels);
+  for (auto& filters : separate) {
+    for (const int window : kWindows) {
+      filters.emplace_back(window);
+    }
+  }
+  run(
+      "One MovingAverageFilter per window",
+      sizeof(double) * total * kChannels,
+      [&](const double value) {
+        double sum{0};
+        for (int cc{0}; cc < kChannels; ++cc) {
+          for (auto& filter : separate[cc]) {
+            double data_out;
+            filter.filter(value + cc, data_out);
+            sum += data_out;
+          }
+        }
+        return sum;
+      },
+      signal);
+
+  std::vector<MultiWindowAverageFilter<double>> shared(
+      kChannels, MultiWindowAverageFilter<double>{kWindows});
+  run(
+      "MultiWindowAverageFilter",
+      sizeof(double) * largest * kChannels,
+      [&](const double value) {
+        double sum{0};
+        double data_out[3];
+        for (int cc{0}; cc < kChannels; ++cc) {
+          shared[cc].filter(value + cc, data_out);
+          sum += data_out[0] + data_out[1] + data_out[2];
+        }
+        return sum;
+      },
+      signal);
+}
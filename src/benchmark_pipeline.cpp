@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "biquad.hpp"
+#include "design.hpp"
+#include "pipeline.hpp"
+
+constexpr int kSamples{1 << 22};
+constexpr int kBlock{1024};
+constexpr int kFactor{4};
+constexpr int kPipelines{8};
+
+static constexpr auto kAntiAlias{
+    butterworth_low_pass<double, 4>(100.0, 1000.0)};
+
+/**
+ * @brief Time a function running `pipelines` pipelines and print ns per sample
+ *
+ */
+template <typename F>
+void run(const std::string& name, const int pipelines, F body) {
+  const auto start{std::chrono::steady_clock::now()};
+  const double checksum{body()};
+  const auto stop{std::chrono::steady_clock::now()};
+
+  const double ns{
+      std::chrono::duration<double, std::nano>(stop - start).count()};
+  std::cout << std::left << std::setw(40) << name << std::right << std::setw(10)
+            << std::fixed << std::setprecision(3)
+            << ns / (static_cast<double>(kSamples) * pipelines)
+            << " ns/sample   (checksum " << checksum << ")\n";
+}
+
+int main() {
+  std::vector<double> signal(kSamples);
+  for (int ii{0}; ii < kSamples; ++ii) {
+    signal[ii] = sin(2 * M_PI * ii / 250.0) + 0.1 * sin(ii);
+  }
+
+  std::cout << "acquire -> 4th order low-pass -> decimate by " << kFactor
+            << " -> sum, blocks of " << kBlock << "\n";
+
+  run("Hand-written loop", 1, [&]() {
+    BiquadFilter<double> filter{kAntiAlias};
+    std::vector<double> filtered(kBlock);
+    double sum{0};
+    int phase{0};
+    for (int start{0}; start < kSamples; start += kBlock) {
+      const int size{std::min(kBlock, kSamples - start)};
+      filter.filter_block(signal.data() + start, filtered.data(), size);
+      for (; phase < size; phase += kFactor) {
+        sum += filtered[phase];
+      }
+      phase -= size;
+    }
+    return sum;
+  });
+
+  run("Coroutine pipeline, inline executor", 1, [&]() {
+    BiquadFilter<double> filter{kAntiAlias};
+    double sum{0};
+    InlineExecutor executor;
+    run_pipeline(
+        executor,
+        decimate(filter_blocks(blocks_of(std::span<const double>{signal},
+                                         kBlock),
+                               filter),
+                 kFactor),
+        [&](const std::span<const double> block) {
+          for (const double value : block) {
+            sum += value;
+          }
+        });
+    return sum;
+  });
+
+  run("Coroutine pipelines, thread pool", kPipelines, [&]() {
+    std::vector<BiquadFilter<double>> filters(kPipelines,
+                                              BiquadFilter<double>{kAntiAlias});
+    std::vector<double> sums(kPipelines);
+    ThreadPool pool;
+    for (int pp{0}; pp < kPipelines; ++pp) {
+      run_pipeline(
+          pool,
+          decimate(filter_blocks(blocks_of(std::span<const double>{signal},
+                                           kBlock),
+                                 filters[pp]),
+                   kFactor),
+          [&sums, pp](const std::span<const double> block) {
+            double block_sum{0};
+            for (const double value : block) {
+              block_sum += value;
+            }
+            sums[pp] += block_sum;
+          });
+    }
+    pool.wait();
+    return sums[0];
+  });
+}
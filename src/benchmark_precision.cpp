@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "filter.hpp"
+
+/**
+ * @brief Time a filter over a signal and compare it to a long double reference
+ *
+ * @tparam T - sample type of the filter
+ * @tparam F - filter type
+ */
+template <typename T, typename F>
+void run(const std::string& name, F filter, const std::vector<double>& signal,
+         const std::vector<long double>& reference, const int window) {
+  std::vector<T> data_in(signal.begin(), signal.end());
+  std::vector<T> data_out(signal.size());
+
+  const auto start{std::chrono::steady_clock::now()};
+  for (std::size_t ii{0}; ii < data_in.size(); ++ii) {
+    filter.filter(data_in[ii], data_out[ii]);
+  }
+  const auto stop{std::chrono::steady_clock::now()};
+
+  long double error{0};
+  for (std::size_t ii{signal.size() / 2}; ii < signal.size(); ++ii) {
+    error = std::fmax(error, std::fabs(data_out[ii] - reference[ii]));
+  }
+
+  const double ns{std::chrono::duration<double, std::nano>(stop - start).count()};
+  std::cout << std::left << std::setw(36) << name << std::right << std::setw(10)
+            << std::fixed << std::setprecision(3) << ns / signal.size()
+            << " ns/sample" << std::setw(10) << window * sizeof(T) + sizeof(F)
+            << " bytes" << std::setw(14) << std::scientific
+            << std::setprecision(2) << static_cast<double>(error)
+            << " max error\n";
+}
+
+int main() {
+  // Define random generator with Gaussian distribution
+  const double mean = 1000.0;
+  const double stddev = 1.0;
+  std::default_random_engine generator;
+  std::normal_distribution<double> dist(mean, stddev);
+
+  // A large DC offset is where a float running sum drifts
+  constexpr int n = 10000000;
+  constexpr int window = 1000;
+  const double alpha{0.001};
+
+  std::vector<double> signal(n);
+  for (int ii{0}; ii < n; ++ii) {
+    signal[ii] = sin(2 * M_PI * ii / 36000.0) + dist(generator);
+  }
+
+  // Long double references
+  std::vector<long double> ref_m(n);
+  std::vector<long double> ref_e(n);
+  {
+    MovingAverageFilter<long double> m{window};
+    ExponentialFilter<long double> e{alpha};
+    for (int ii{0}; ii < n; ++ii) {
+      m.filter(signal[ii], ref_m[ii]);
+      e.filter(signal[ii], ref_e[ii]);
+    }
+  }
+
+  std::cout << "Moving average, window " << window << "\n";
+  run<double>("double", MovingAverageFilter<double>{window}, signal, ref_m,
+              window);
+  run<float>("float", MovingAverageFilter<float>{window}, signal, ref_m,
+             window);
+  run<float>("float, double sum",
+             MovingAverageFilter<float, Precision<float, double>>{window},
+             signal, ref_m, window);
+#ifdef __FLT16_MAX__
+  run<_Float16>("_Float16, float sum",
+                MovingAverageFilter<_Float16, Precision<float>>{window},
+                signal, ref_m, window);
+  run<_Float16>("_Float16, double sum",
+                MovingAverageFilter<_Float16, Precision<float, double>>{window},
+                signal, ref_m, window);
+#endif
+
+  std::cout << "\nExponential, alpha " << alpha << "\n";
+  run<double>("double", ExponentialFilter<double>{alpha}, signal, ref_e, 0);
+  run<float>("float", ExponentialFilter<float>{static_cast<float>(alpha)},
+             signal, ref_e, 0);
+  run<float>("float, double state",
+             ExponentialFilter<float, Precision<double>>{alpha}, signal, ref_e,
+             0);
+#ifdef __FLT16_MAX__
+  run<_Float16>("_Float16, float state",
+                ExponentialFilter<_Float16, Precision<float>>{
+                    static_cast<float>(alpha)},
+                signal, ref_e, 0);
+#endif
+}
@@ -0,0 +1,44 @@
+#include <cmath>
+#include <iostream>
+
+#include "biquad.hpp"
+#include "fir.hpp"
+
+// Designs evaluated entirely at compile time
+static constexpr double kSampleRate{1000};
+static constexpr double kAlpha{low_pass_constant(5.0, kSampleRate)};
+static constexpr auto kButterworth =
+    butterworth_low_pass<double, 4>(20.0, kSampleRate);
+static constexpr auto kTaps = fir_low_pass<double, 31>(20.0, kSampleRate);
+
+static_assert(is_valid_filter_constant(kAlpha), "Invalid filter constant");
+static_assert(is_stable(kButterworth), "Unstable design");
+
+int main() {
+  StaticExponentialFilter<double, kAlpha> lp;
+  StaticBiquadFilter<double, kButterworth> butterworth;
+  StaticFIRFilter<double, kTaps> fir;
+
+  // Measure the steady-state amplitude of a few tones
+  for (const double freq : {1.0, 10.0, 20.0, 50.0, 200.0}) {
+    lp.reset();
+    butterworth.reset();
+    fir.reset();
+
+    double amp_lp{0};
+    double amp_bw{0};
+    double amp_fir{0};
+    double out{0};
+    for (int ii{0}; ii < 10000; ++ii) {
+      const double y{sin(2 * M_PI * freq * ii / kSampleRate)};
+      lp.filter(y, out);
+      amp_lp = ii > 5000 ? std::fmax(amp_lp, out) : 0;
+      butterworth.filter(y, out);
+      amp_bw = ii > 5000 ? std::fmax(amp_bw, out) : 0;
+      fir.filter(y, out);
+      amp_fir = ii > 5000 ? std::fmax(amp_fir, out) : 0;
+    }
+    std::cout << freq << " Hz - Exponential: " << amp_lp
+              << " Butterworth: " << amp_bw << " FIR: " << amp_fir << "\n";
+  }
+}
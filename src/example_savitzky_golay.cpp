@@ -0,0 +1,54 @@
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "savgol.hpp"
+
+int main() {
+  // Define random generator with Gaussian distribution
+  const double mean = 0.0;
+  const double stddev = 0.01;
+  std::default_random_engine generator;
+  std::normal_distribution<double> dist(mean, stddev);
+
+  const double dt{0.01};
+  SavitzkyGolayFilter<double> smooth{21, 3, 0, dt};
+  SavitzkyGolayFilter<double> velocity{21, 3, 1, dt};
+  SavitzkyGolayBank<double, 2> bank{21, 3, 1, dt};
+
+  // Weights can also be generated at compile time
+  constexpr auto weights = savitzky_golay_coefficients<double, 5, 2>();
+  static_assert(weights[2] > weights[0], "Centre weight dominates");
+
+  // Prepare data.
+  constexpr int n = 1000;
+
+  std::vector<double> y(n);
+  std::vector<double> y_s(n);
+  std::vector<double> y_v(n);
+  std::vector<double> y_b(n);
+
+  for (int ii{0}; ii < n; ++ii) {
+    y[ii] = sin(ii * dt) + dist(generator);
+  }
+
+  smooth.filter_block(y.data(), y_s.data(), n);
+  for (int ii{0}; ii < n; ++ii) {
+    velocity.filter(y[ii], y_v[ii]);
+
+    std::array<double, 2> frame_out{};
+    bank.filter({y[ii], -y[ii]}, frame_out);
+    y_b[ii] = frame_out[0];
+  }
+
+  // Outputs describe the input group_delay() samples ago
+  const int delay{velocity.group_delay()};
+  for (int ii{100}; ii < n; ii += 100) {
+    const double t{(ii - delay) * dt};
+    std::cout << "t: " << t << " smooth: " << y_s[ii] << " (" << sin(t)
+              << ") velocity: " << y_v[ii] << " (" << cos(t)
+              << ") bank: " << y_b[ii] << "\n";
+  }
+}
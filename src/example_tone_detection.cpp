@@ -0,0 +1,50 @@
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "spectral.hpp"
+
+int main() {
+  // Define random generator with Gaussian distribution
+  const double mean = 0.0;
+  const double stddev = 0.1;
+  std::default_random_engine generator;
+  std::normal_distribution<double> dist(mean, stddev);
+
+  // Mains hum and its third harmonic, sampled at 1 kHz
+  const double sample_rate{1000};
+  const int window{200};
+  const std::vector<int> bins{dft_bin(60.0, sample_rate, window),
+                              dft_bin(180.0, sample_rate, window)};
+
+  SlidingDFTFilter<double> sdft{window, bins};
+  GoertzelFilter<double> goertzel{window, {60.0, 180.0}, sample_rate};
+  SlidingDFTBank<double, 4> bank{window, bins};
+
+  // Prepare data.
+  constexpr int n = 2000;
+
+  double out_s{0};
+  double out_g{0};
+  std::array<double, 4> out_b{};
+
+  for (int ii{0}; ii < n; ++ii) {
+    const double t{ii / sample_rate};
+    const double hum{1.5 * sin(2 * M_PI * 60 * t) +
+                     0.2 * sin(2 * M_PI * 180 * t)};
+    const double y{hum + dist(generator)};
+
+    sdft.filter(y, out_s);
+    goertzel.filter(y, out_g);
+    bank.filter({y, 2 * y, dist(generator), hum}, out_b);
+
+    if (ii % 250 == 249) {
+      std::cout << "Sliding DFT: " << sdft.amplitude(0) << " / "
+                << sdft.amplitude(1) << " Goertzel: " << goertzel.amplitude(0)
+                << " / " << goertzel.amplitude(1) << " Bank: " << out_b[0]
+                << " " << out_b[1] << " " << out_b[2] << " " << out_b[3]
+                << "\n";
+    }
+  }
+}
@@ -0,0 +1,123 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "autotune.hpp"
+#include "batch.hpp"
+#include "chain.hpp"
+
+/**
+ * @brief Print the command line usage
+ *
+ */
+void usage(const char* name) {
+  std::cerr
+      << "Usage: " << name << " [options] -o OUTDIR INPUT...\n"
+      << "Filter raw binary sample files, writing OUTDIR/<input name>.\n\n"
+      << "  -f SPEC        add a filter to the chain (repeatable), e.g.\n"
+      << "                 exp:0.1, ma:20[:partial|first], lp:RC:DT, hp:RC:DT\n"
+      << "                 sg:11:3, ewstat:0.01:z and wstat:100:kurt\n"
+      << "  -c CHANNELS    channels per file (default 1)\n"
+      << "  -t TYPE        sample type, float or double (default double)\n"
+      << "  -j JOBS        files processed in parallel (default: all cores)\n"
+      << "  -p PROFILE     build each filter with the fastest implementation\n"
+      << "                 saved in PROFILE, measuring missing ones\n"
+      << "  --planar       channels are stored one after another\n"
+      << "  --no-huge-pages  do not ask for transparent huge pages\n";
+}
+
+/**
+ * @brief Filter all the files with sample type T
+ *
+ */
+template <typename T>
+void run(const std::vector<std::string>& specs,
+         const std::vector<std::pair<std::string, std::string>>& jobs,
+         const BatchOptions& options, const int threads,
+         const std::string& profile) {
+  Autotuner<T> tuner{profile};
+  const FilterChain<T> chain{
+      profile.empty()
+          ? make_filter_chain<T>(specs)
+          : make_tuned_filter_chain(tuner, specs, options.channels)};
+  filter_files<T>(jobs, chain, options, threads);
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> specs;
+  std::vector<std::string> inputs;
+  std::string output_dir;
+  std::string type{"double"};
+  BatchOptions options;
+  int threads{0};
+  std::string profile;
+
+  try {
+    for (int ii{1}; ii < argc; ++ii) {
+      const std::string arg{argv[ii]};
+      const auto value = [&]() {
+        if (ii + 1 >= argc) {
+          throw std::invalid_argument("Missing value for " + arg);
+        }
+        return std::string{argv[++ii]};
+      };
+
+      if (arg == "-f") {
+        specs.push_back(value());
+      } else if (arg == "-c") {
+        options.channels = std::stoi(value());
+      } else if (arg == "-t") {
+        type = value();
+      } else if (arg == "-p") {
+        profile = value();
+      } else if (arg == "-j") {
+        threads = std::stoi(value());
+      } else if (arg == "-o") {
+        output_dir = value();
+      } else if (arg == "--planar") {
+        options.layout = SampleLayout::Planar;
+      } else if (arg == "--no-huge-pages") {
+        options.huge_pages = false;
+      } else if ((arg == "-h") || (arg == "--help")) {
+        usage(argv[0]);
+        return 0;
+      } else {
+        inputs.push_back(arg);
+      }
+    }
+    if (output_dir.empty() || inputs.empty()) {
+      usage(argv[0]);
+      return 1;
+    }
+
+    std::vector<std::pair<std::string, std::string>> jobs;
+    for (const auto& input : inputs) {
+      const std::string name{input.substr(input.find_last_of('/') + 1)};
+      jobs.emplace_back(input, output_dir + "/" + name);
+    }
+
+    const auto start{std::chrono::steady_clock::now()};
+    if (type == "float") {
+      run<float>(specs, jobs, options, threads, profile);
+    } else if (type == "double") {
+      run<double>(specs, jobs, options, threads, profile);
+    } else {
+      throw std::invalid_argument("Unknown sample type '" + type + "'");
+    }
+    const auto stop{std::chrono::steady_clock::now()};
+
+    double bytes{0};
+    for (const auto& job : jobs) {
+      bytes += MappedFile{job.first}.size();
+    }
+    const double seconds{std::chrono::duration<double>(stop - start).count()};
+    std::cout << "Filtered " << jobs.size() << " files, " << bytes / 1e6
+              << " MB in " << seconds << " s (" << bytes / 1e6 / seconds
+              << " MB/s)\n";
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+}
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "batch.hpp"
+#include "chain.hpp"
+#include "replay.hpp"
+
+/**
+ * @brief Print the command line usage
+ *
+ */
+void usage(const char* name) {
+  std::cerr
+      << "Usage: " << name << " [options] -f SPEC... CAPTURE\n"
+      << "       " << name << " --import RAW -c CHANNELS -r RATE CAPTURE\n"
+      << "Replay a recorded input stream through a filter chain, or convert\n"
+      << "a raw interleaved sample file into a capture.\n\n"
+      << "  -f SPEC        add a filter to the chain (repeatable), e.g.\n"
+      << "                 exp:0.1, ma:20[:partial|first], lp:RC:DT, hp:RC:DT\n"
+      << "                 sg:11:3, ewstat:0.01:z and wstat:100:kurt\n"
+      << "  --realtime     feed frames at their recorded times\n"
+      << "  --speed X      with --realtime, replay X times faster\n"
+      << "  -n REPEATS     replays at full speed, the fastest is reported\n"
+      << "  --save GOLDEN  write the outputs as a golden capture\n"
+      << "  --compare GOLDEN  check the outputs match GOLDEN bit for bit\n"
+      << "                 (exit status 2 if they do not)\n"
+      << "  --import RAW   read samples from a raw file instead\n"
+      << "  -c CHANNELS    channels of the raw file (default 1)\n"
+      << "  -t TYPE        sample type of the raw file, float or double\n"
+      << "                 (default double)\n"
+      << "  -r RATE        sample rate of the raw file [Hz] (default 1)\n";
+}
+
+/**
+ * @brief Write a raw interleaved sample file as an evenly spaced capture
+ *
+ */
+template <typename T>
+void import(const std::string& raw, const std::string& path,
+            const int channels, const double sample_rate) {
+  if (!(sample_rate > 0)) {
+    throw std::domain_error("Sample rate must be positive");
+  }
+  if (channels < 1) {
+    throw std::domain_error("Number of channels must be positive");
+  }
+  const MappedFile input{raw};
+  const long frame_bytes{static_cast<long>(sizeof(T)) * channels};
+  if (input.size() % frame_bytes != 0) {
+    throw std::runtime_error("'" + raw +
+                             "' does not hold a whole number of frames");
+  }
+  const T* samples{reinterpret_cast<const T*>(input.data())};
+  CaptureWriter<T> writer{path, channels};
+  for (long ff{0}; ff < input.size() / frame_bytes; ++ff) {
+    writer.write(samples + ff * channels,
+                 static_cast<std::int64_t>(ff * 1e9 / sample_rate));
+  }
+  writer.close();
+  std::cout << "Wrote " << writer.frames() << " frames to " << path << "\n";
+}
+
+/**
+ * @brief Replay a capture with sample type T, returning the exit status
+ *
+ */
+template <typename T>
+int run(const std::string& path, const std::vector<std::string>& specs,
+        const ReplayOptions& options, const std::string& save,
+        const std::string& compare) {
+  const Capture<T> capture{Capture<T>::load(path)};
+  const FilterChain<T> chain{make_filter_chain<T>(specs)};
+  const ReplayResult<T> result{replay(capture, chain, options)};
+
+  std::cout << "Replayed " << result.frames << " frames x " << result.channels
+            << " channels in " << result.seconds << " s ("
+            << result.samples_per_second() / 1e6 << " M samples/s)\n";
+  if (options.pacing == Pacing::RealTime) {
+    std::cout << "Worst lateness " << result.max_lateness * 1e6 << " us\n";
+  }
+  if (!save.empty()) {
+    save_golden(save, capture, result);
+    std::cout << "Saved golden outputs to " << save << "\n";
+  }
+  if (!compare.empty()) {
+    const GoldenComparison comparison{
+        compare_golden(result, Capture<T>::load(compare))};
+    if (!comparison.shape_matches) {
+      std::cout << "Outputs do not have the shape of " << compare << "\n";
+      return 2;
+    }
+    if (!comparison.identical()) {
+      std::cout << comparison.mismatches << " samples differ from " << compare
+                << ", first at frame " << comparison.first_frame
+                << " channel " << comparison.first_channel
+                << ", largest difference " << comparison.max_error << "\n";
+      return 2;
+    }
+    std::cout << "Outputs match " << compare << " bit for bit\n";
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> specs;
+  std::string capture;
+  std::string raw;
+  std::string save;
+  std::string compare;
+  std::string type{"double"};
+  ReplayOptions options;
+  int channels{1};
+  double sample_rate{1};
+
+  try {
+    for (int ii{1}; ii < argc; ++ii) {
+      const std::string arg{argv[ii]};
+      const auto value = [&]() {
+        if (ii + 1 >= argc) {
+          throw std::invalid_argument("Missing value for " + arg);
+        }
+        return std::string{argv[++ii]};
+      };
+
+      if (arg == "-f") {
+        specs.push_back(value());
+      } else if (arg == "--realtime") {
+        options.pacing = Pacing::RealTime;
+      } else if (arg == "--speed") {
+        options.speed = std::stod(value());
+      } else if (arg == "-n") {
+        options.repeats = std::stoi(value());
+      } else if (arg == "--save") {
+        save = value();
+      } else if (arg == "--compare") {
+        compare = value();
+      } else if (arg == "--import") {
+        raw = value();
+      } else if (arg == "-c") {
+        channels = std::stoi(value());
+      } else if (arg == "-t") {
+        type = value();
+      } else if (arg == "-r") {
+        sample_rate = std::stod(value());
+      } else if ((arg == "-h") || (arg == "--help")) {
+        usage(argv[0]);
+        return 0;
+      } else {
+        capture = arg;
+      }
+    }
+    if (capture.empty() || (raw.empty() && specs.empty())) {
+      usage(argv[0]);
+      return 1;
+    }
+
+    if (!raw.empty()) {
+      if (type == "float") {
+        import<float>(raw, capture, channels, sample_rate);
+      } else if (type == "double") {
+        import<double>(raw, capture, channels, sample_rate);
+      } else {
+        throw std::invalid_argument("Unknown sample type '" + type + "'");
+      }
+      return 0;
+    }
+
+    if (read_capture_info(capture).type == CaptureType::Float) {
+      return run<float>(capture, specs, options, save, compare);
+    }
+    return run<double>(capture, specs, options, save, compare);
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+}
@@ -0,0 +1,106 @@
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "analysis.hpp"
+#include "chain.hpp"
+
+/**
+ * @brief Print the command line usage
+ *
+ */
+void usage(const char* name) {
+  std::cerr
+      << "Usage: " << name << " [options] -f SPEC...\n"
+      << "Write the response of a filter chain as CSV.\n\n"
+      << "  -f SPEC        add a filter to the chain (repeatable), e.g.\n"
+      << "                 exp:0.1, ma:20, lp:RC:DT, hp:RC:DT and sg:11:3\n"
+      << "  -r RATE        sample rate [Hz] (default 1)\n"
+      << "  -n POINTS      frequencies from 0 to Nyquist (default 1024)\n"
+      << "  -l LENGTH      longest impulse response used (default 65536)\n"
+      << "  --impulse N    write the first N samples of the impulse response\n"
+      << "  --step N       write the first N samples of the step response\n"
+      << "  -o FILE        write to FILE instead of standard output\n";
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> specs;
+  std::string output;
+  std::string mode{"frequency"};
+  double sample_rate{1};
+  int points{1024};
+  int length{1 << 16};
+
+  try {
+    for (int ii{1}; ii < argc; ++ii) {
+      const std::string arg{argv[ii]};
+      const auto value = [&]() {
+        if (ii + 1 >= argc) {
+          throw std::invalid_argument("Missing value for " + arg);
+        }
+        return std::string{argv[++ii]};
+      };
+
+      if (arg == "-f") {
+        specs.push_back(value());
+      } else if (arg == "-r") {
+        sample_rate = std::stod(value());
+      } else if (arg == "-n") {
+        points = std::stoi(value());
+      } else if (arg == "-l") {
+        length = std::stoi(value());
+      } else if ((arg == "--impulse") || (arg == "--step")) {
+        mode = arg.substr(2);
+        length = std::stoi(value());
+      } else if (arg == "-o") {
+        output = value();
+      } else if ((arg == "-h") || (arg == "--help")) {
+        usage(argv[0]);
+        return 0;
+      } else {
+        throw std::invalid_argument("Unknown option " + arg);
+      }
+    }
+    if (specs.empty()) {
+      usage(argv[0]);
+      return 1;
+    }
+
+    std::ofstream file;
+    if (!output.empty()) {
+      file.open(output);
+      if (!file) {
+        throw std::runtime_error("Cannot open " + output);
+      }
+    }
+    std::ostream& out{output.empty() ? std::cout : file};
+    out.precision(std::numeric_limits<double>::max_digits10);
+
+    const FilterChain<double> chain{make_filter_chain<double>(specs)};
+    if (mode == "frequency") {
+      const FrequencyResponse response{frequency_response(
+          chain, linear_frequencies(points, sample_rate), sample_rate,
+          length)};
+      out << "frequency,magnitude,magnitude_db,phase,group_delay\n";
+      for (int kk{0}; kk < points; ++kk) {
+        out << response.frequency[kk] << "," << response.magnitude[kk] << ","
+            << response.magnitude_db(kk) << "," << response.phase[kk] << ","
+            << response.group_delay[kk] << "\n";
+      }
+    } else {
+      const std::vector<double> response{
+          mode == "impulse" ? impulse_response(chain, length)
+                            : step_response(chain, length)};
+      out << "sample,time," << mode << "\n";
+      for (int ii{0}; ii < length; ++ii) {
+        out << ii << "," << ii / sample_rate << "," << response[ii] << "\n";
+      }
+    }
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+}
@@ -0,0 +1,92 @@
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "autotune.hpp"
+
+/**
+ * @brief Print the command line usage
+ *
+ */
+void usage(const char* name) {
+  std::cerr
+      << "Usage: " << name << " [options] SPEC...\n"
+      << "Measure the implementations of each filter and save the fastest to\n"
+      << "a profile read by Autotuner (and filter_batch -p).\n\n"
+      << "  -p PROFILE     profile file (default $FILTERING_PROFILE or\n"
+      << "                 filtering_profile.txt)\n"
+      << "  -c CHANNELS    channels the filters will run on (default 1)\n"
+      << "  -t TYPE        sample type, float or double (default double)\n";
+}
+
+/**
+ * @brief Tune every specification for sample type T and print the costs
+ *
+ */
+template <typename T>
+void tune(const std::vector<std::string>& specs, const std::string& profile,
+          const int channels) {
+  Autotuner<T> tuner{profile};
+  for (const auto& spec : specs) {
+    const TuneResult best{tuner.tune(spec, channels)};
+    std::cout << spec << " -> " << best.name << "\n";
+    for (const auto& result : tuner.results()) {
+      std::cout << "  " << std::left << std::setw(16) << result.name
+                << std::right << std::fixed << std::setprecision(3)
+                << std::setw(10) << result.ns_per_sample << " ns/sample\n";
+    }
+  }
+  std::cout << "Saved to " << tuner.profile().path() << "\n";
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> specs;
+  std::string profile{FilterProfile::default_path()};
+  std::string type{"double"};
+  int channels{1};
+
+  try {
+    for (int ii{1}; ii < argc; ++ii) {
+      const std::string arg{argv[ii]};
+      const auto value = [&]() {
+        if (ii + 1 >= argc) {
+          throw std::invalid_argument("Missing value for " + arg);
+        }
+        return std::string{argv[++ii]};
+      };
+
+      if (arg == "-p") {
+        profile = value();
+      } else if (arg == "-c") {
+        channels = std::stoi(value());
+      } else if (arg == "-t") {
+        type = value();
+      } else if ((arg == "-h") || (arg == "--help")) {
+        usage(argv[0]);
+        return 0;
+      } else {
+        specs.push_back(arg);
+      }
+    }
+    if (specs.empty()) {
+      usage(argv[0]);
+      return 1;
+    }
+    if (channels < 1) {
+      throw std::domain_error("Number of channels must be positive");
+    }
+
+    if (type == "float") {
+      tune<float>(specs, profile, channels);
+    } else if (type == "double") {
+      tune<double>(specs, profile, channels);
+    } else {
+      throw std::invalid_argument("Unknown sample type '" + type + "'");
+    }
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+}
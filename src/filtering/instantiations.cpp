@@ -0,0 +1,50 @@
+/**
+ * @file instantiations.cpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Common filter instantiations of the compiled filtering library
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "filtering/biquad.hpp"
+#include "filtering/chain.hpp"
+#include "filtering/filter.hpp"
+#include "filtering/fir.hpp"
+#include "filtering/multistream.hpp"
+
+// FILTERS *********************************************************************
+
+template class ExponentialFilter<float>;
+template class ExponentialFilter<double>;
+template class MovingAverageFilter<float>;
+template class MovingAverageFilter<double>;
+template class MultiWindowAverageFilter<float>;
+template class MultiWindowAverageFilter<double>;
+template class LowPassFilter<float>;
+template class LowPassFilter<double>;
+template class HighPassFilter<float>;
+template class HighPassFilter<double>;
+
+template class FIRFilter<float>;
+template class FIRFilter<double>;
+template class BiquadFilter<float>;
+template class BiquadFilter<double>;
+template class FilterChain<float>;
+template class FilterChain<double>;
+
+// MULTI-STREAM FILTERS ********************************************************
+
+#define FILTERING_INSTANTIATE_BANKS(N)             \
+  template class MultiStreamFilter<float, N>;      \
+  template class MultiStreamFilter<double, N>;     \
+  template class ExponentialFilterBank<float, N>;  \
+  template class ExponentialFilterBank<double, N>;
+FILTERING_INSTANTIATE_BANKS(2)
+FILTERING_INSTANTIATE_BANKS(4)
+FILTERING_INSTANTIATE_BANKS(8)
+FILTERING_INSTANTIATE_BANKS(16)
+FILTERING_INSTANTIATE_BANKS(32)
+FILTERING_INSTANTIATE_BANKS(64)
+#undef FILTERING_INSTANTIATE_BANKS
@@ -0,0 +1,24 @@
+/**
+ * @file kernels.cpp
+ * @author Gedaliah Knizhnik (gedaliah.knizhnik@gmail.com)
+ * @brief Dispatched SIMD kernels of the compiled filtering library
+ * @version 0.2
+ * @date 2023-11-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * This file is built with the optimization flags the kernels are tuned for,
+ * whatever flags the code that links the library uses.
+ */
+#include "filtering/dispatch.hpp"
+
+template void fir_convolve<float>(const float*, int, const float*, float*,
+                                  int);
+template void fir_convolve<double>(const double*, int, const double*, double*,
+                                   int);
+template void exponential_bank<float, float>(const float*, const float*,
+                                             float*, const float*, float*, int,
+                                             int);
+template void exponential_bank<double, double>(const double*, const double*,
+                                               double*, const double*, double*,
+                                               int, int);